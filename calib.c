@@ -0,0 +1,307 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "globals.h"
+#include "speed.h"
+#include "observer.h"
+#include "control.h"
+#include "motion.h"
+#include "snapshot.h"
+#include "eelog.h"
+#include "protect.h"
+#include "calib.h"
+
+#if CalBase < LogBase + LogBlocks * LogBlockSize || CalBase + CalSize > 0x100
+#error "The feedforward table must fit in the EEPROM above the log blocks"
+#endif
+
+#if CalTopRPS >= ((CalPoints - 1L) << CalLog2Step) || CalTopRPS > 32767
+#error "CalTopRPS must be inside the table and fit an int"
+#endif
+
+/******************************************************************************/
+/* Calibration Variables                                                      */
+/******************************************************************************/
+
+volatile unsigned char CalStatus;   // CalNone, CalReady, CalRunning or CalFailed
+
+static unsigned int CalTable[CalPoints];    // Duty at speed i << CalLog2Step, read by ControlTick
+static volatile unsigned char CalValid;     // CalTable holds a table
+static unsigned int CalNew[CalPoints];      // Table being built, copied to CalTable
+static unsigned int CalSpeed[CalSteps];     // Sweep: mean speed at each duty step (milli-rev/s)
+static unsigned char CalAxis;       // Axis being swept
+static unsigned char CalStep;       // Duty step being measured
+static unsigned char CalRuns;       // CalTask runs into the step
+static long CalSum;                 // Speed samples of the step
+static long CalResume;              // Setpoint to go back to after the sweep
+static unsigned char CalSave;       // Next EEPROM byte to queue, CalSize when saved
+static unsigned char CalCheck;      // Sum of the bytes queued so far
+
+/******************************************************************************/
+/* Calibration Functions                                                      */
+/******************************************************************************/
+
+/*******************************
+ * CalInit(void)
+ *
+ * Loads the table from the EEPROM if its magic byte and checksum match and
+ * its entries never fall, otherwise runs without feedforward. Call before
+ * InitInterrupts.
+ *******************************/
+void CalInit(void)
+{
+    unsigned char i;
+    unsigned char sum = CalMagic;
+    unsigned char lo;
+    unsigned char hi;
+    unsigned char ok = (HalEERead(CalBase) == CalMagic);
+
+    for (i = 0; i < CalPoints; i++)
+    {
+        lo = HalEERead(CalBase + 1 + 2*i);
+        hi = HalEERead(CalBase + 2 + 2*i);
+        sum += lo + hi;
+        CalTable[i] = ((unsigned int)hi << 8) | lo;
+        if (CalTable[i] > DutyMax || (i > 0 && CalTable[i] < CalTable[i-1]))
+        {
+            ok = 0;
+        }
+    }
+    ok = ok && (HalEERead(CalBase + CalSize - 1) == sum);
+    CalValid = ok;
+    CalStatus = ok ? CalReady : CalNone;
+    CalSave = CalSize;
+}
+
+/*******************************
+ * CalStart(unsigned char a)
+ *
+ * Starts a sweep of axis a: ends its move, opens its loop at zero duty and
+ * remembers its setpoint to go back to. Main loop only, with no fault
+ * latched and no sweep running.
+ *******************************/
+void CalStart(unsigned char a)
+{
+    MoveStop(a);                        // SetRPS[a] stays put from here
+    CalResume = SetRPS[a];
+    SetDutyManual(a, 0);
+    CalAxis = a;
+    CalStep = 0;
+    CalRuns = 0;
+    CalSum = 0;
+    CalStatus = CalRunning;
+}
+
+/*******************************
+ * CalBuild(unsigned char n)
+ *
+ * Inverts the n measured steps into CalNew, the duty at each table speed v:
+ * linear between the two steps around v, the first faster than v and the
+ * one before it, or beyond the last step along the last rising segment,
+ * clamped to 0..DutyMax. Speeds are first made non-decreasing from the top
+ * down, as a step can only read high (the motor still coasting down at the
+ * first ones), so that entry 0 comes out as the highest duty that still gave
+ * 0 and the entries never fall. Returns 0 if the motor never turned.
+ *******************************/
+static unsigned char CalBuild(unsigned char n)
+{
+    unsigned char j;
+    unsigned char k;
+    unsigned int v;
+    long d;
+
+    for (j = n-1; j > 0; j--)
+    {
+        if (CalSpeed[j-1] > CalSpeed[j])
+        {
+            CalSpeed[j-1] = CalSpeed[j];
+        }
+    }
+    if (n < 2 || CalSpeed[n-1] == 0)
+    {
+        return 0;
+    }
+
+    j = 1;
+    for (k = 0; k < CalPoints; k++)
+    {
+        v = (unsigned int)k << CalLog2Step;
+        while (j < n-1 && CalSpeed[j] <= v)
+        {
+            j++;
+        }
+        while (j > 1 && CalSpeed[j] == CalSpeed[j-1])
+        {
+            j--;                        // Flat end: back to the last rise
+        }
+        if (v < CalSpeed[0])
+        {
+            d = 0;                      // Already turns this fast at duty 0
+        }
+        else if (CalSpeed[j] == CalSpeed[j-1])
+        {
+            d = DutyMax;                // No rise at all past the first step
+        }
+        else
+        {
+            d = (long)(j-1) * CalDutyStep +
+                ((long)v - CalSpeed[j-1]) * CalDutyStep / (long)(CalSpeed[j] - CalSpeed[j-1]);
+        }
+        if (d > DutyMax)
+        {
+            d = DutyMax;
+        }
+        if (k > 0 && d < (long)CalNew[k-1])
+        {
+            d = CalNew[k-1];
+        }
+        CalNew[k] = (unsigned int)d;
+    }
+    return 1;
+}
+
+/*******************************
+ * CalDone(void)
+ *
+ * Ends the sweep: builds the table and swaps it in with the Timer2 interrupt
+ * masked, so ControlTick never reads half of it, then queues it for the
+ * EEPROM. The axis goes back to its old setpoint, closed loop, moving from
+ * the speed the sweep ended at.
+ *******************************/
+static void CalDone(void)
+{
+    unsigned char i;
+
+    if (CalBuild(CalStep) != 0)
+    {
+        PIE1bits.TMR2IE = 0;            // Hold off ControlTick
+        for (i = 0; i < CalPoints; i++)
+        {
+            CalTable[i] = CalNew[i];
+        }
+        CalValid = 1;
+        PIE1bits.TMR2IE = 1;
+        CalStatus = CalReady;
+        CalSave = 0;
+        CalCheck = 0;
+    }
+    else
+    {
+        CalStatus = CalFailed;
+    }
+    PIE1bits.TMR2IE = 0;                // Close the loop where the sweep ended, bumpless
+    SetRPS[CalAxis] = CalSpeed[CalStep-1];
+    ControlHold(CalAxis, (CalStep-1) * CalDutyStep);
+    CtlEnable[CalAxis] = 1;
+    PIE1bits.TMR2IE = 1;
+    MoveTo(CalAxis, CalResume);
+}
+
+/*******************************
+ * CalTask(void)
+ *
+ * Main loop task, every CalTaskMs. Queues the next bytes of a new table for
+ * the EEPROM while the log queue has room. During a sweep it holds each duty
+ * step for CalSettleRuns runs, then adds the snapshot speed of the axis for
+ * CalMeasureRuns runs; the mean is the speed at that duty. The sweep ends
+ * when the next step would reach CalTopRPS, going by the last one, or at
+ * DutyMax, or when protection trips (the table is then left as it was).
+ *******************************/
+void CalTask(void)
+{
+    SpeedSnap Snap;
+    unsigned char b;
+    long r;
+
+    while (CalSave < CalSize)
+    {
+        if (CalSave == 0)
+        {
+            b = CalMagic;
+        }
+        else if (CalSave == CalSize - 1)
+        {
+            b = CalCheck;
+        }
+        else
+        {
+            b = (unsigned char)(CalTable[(CalSave-1) >> 1] >> ((CalSave & 1) ? 0 : 8));
+        }
+        if (LogPut(CalBase + CalSave, b) == 0)
+        {
+            break;                      // Queue full: the rest next run
+        }
+        CalCheck += b;
+        CalSave++;
+    }
+
+    if (CalStatus != CalRunning)
+    {
+        return;
+    }
+    if (ProtFault != 0)
+    {
+        CalStatus = CalFailed;          // Protection holds the motor off
+        return;
+    }
+    if (++CalRuns <= CalSettleRuns)
+    {
+        return;
+    }
+    SnapRead(&Snap);
+    CalSum += Snap.RPS[CalAxis];
+    if (CalRuns < CalSettleRuns + CalMeasureRuns)
+    {
+        return;
+    }
+
+    r = CalSum / CalMeasureRuns;
+    r = (r < 0) ? 0 : (r > 32767) ? 32767 : r;
+    CalSpeed[CalStep] = (unsigned int)r;
+    if (CalStep > 0)
+    {
+        r += r - CalSpeed[CalStep-1];   // Where the next step would take it
+    }
+    CalStep++;
+    if (r >= CalTopRPS || CalStep >= CalSteps)
+    {
+        CalDone();
+        return;
+    }
+    SetDutyManual(CalAxis, CalStep * CalDutyStep);
+    CalRuns = 0;
+    CalSum = 0;
+}
+
+/*******************************
+ * CalFeedforward(long rps)
+ *
+ * Duty the table gives for speed rps (milli-rev/s), interpolated between
+ * the two entries around it to 1/64 of the spacing, so that the product
+ * fits an unsigned int; 0 at rps <= 0 or without a table, the last entry
+ * above the table. Called by the low priority ISR (ControlTick) and by
+ * ControlHold.
+ *******************************/
+unsigned int CalFeedforward(long rps)
+{
+    unsigned char i;
+    unsigned int lo;
+
+    if (CalValid == 0 || rps <= 0)
+    {
+        return 0;
+    }
+    if (rps >= ((CalPoints - 1L) << CalLog2Step))
+    {
+        return CalTable[CalPoints-1];
+    }
+    i = (unsigned char)(rps >> CalLog2Step);
+    lo = CalTable[i];
+    return lo + (((CalTable[i+1] - lo) *
+                  (unsigned char)(((unsigned int)rps >> (CalLog2Step - 6)) & 63)) >> 6);
+}
@@ -0,0 +1,63 @@
+/*
+ * File:   calib.h
+ *
+ * Duty feedforward from a calibrated duty-to-speed table. Calibration
+ * (CalStart, by command) opens the loop of one axis and steps its duty up
+ * from 0 by CalDutyStep, holding each step until the motor settles and
+ * averaging the measured speed, until the next step would reach CalTopRPS.
+ * The main loop then inverts the curve into the duty needed at speeds 0, 1, 2, ...
+ * CalPoints-1 times 2^CalLog2Step milli-rev/s (entry 0 being the duty where
+ * the motor starts to turn) and saves it in the data EEPROM above the log.
+ * It is loaded at reset. ControlTick adds CalFeedforward(SetRPS) to its PI
+ * output, so a setpoint change gets close to the right duty at once and the
+ * integrator only trims; without a table the feedforward is 0 and the loop
+ * is as before. One table serves every axis.
+ *
+ * EEPROM, from CalBase:
+ *   0      CalMagic
+ *   1..    CalPoints entries, duty 0..DutyMax, little endian
+ *   last   checksum: the sum of the bytes before it
+ */
+
+#ifndef CALIB_H
+#define	CALIB_H
+
+#define CalBase 0xC0            // EEPROM address, just above the log blocks
+#define CalMagic 0x46
+#define CalLog2Step 10          // Table speed spacing, 2^10 milli-rev/s
+#define CalPoints 21            // Entries: 0 to 20.48 rev/s
+#define CalSize (2*CalPoints+2) // EEPROM bytes
+
+#define CalTaskMs 25            // CalTask period, ticks (one sample tick)
+#define CalDutyStep 16          // Duty step of the sweep
+#define CalSteps (DutyMax/CalDutyStep+1) // Most steps of a sweep
+#define CalSettleRuns 12        // CalTask runs to let the motor settle after a step (300 ms)
+#define CalMeasureRuns 8        // ... then to average the speed over (200 ms)
+#if ProtMaxRPS - ProtMaxRPS/8 < ((CalPoints - 1L) << CalLog2Step)
+#define CalTopRPS (ProtMaxRPS - ProtMaxRPS/8) // Sweep stays under this, below the overspeed limit
+#else
+#define CalTopRPS (((CalPoints - 1L) << CalLog2Step) - 1) // ... and inside the table (SpeedTimer1, SpeedMT)
+#endif
+
+// CalStatus
+#define CalNone 0               // No table, no feedforward
+#define CalReady 1              // Table loaded or calibrated
+#define CalRunning 2            // Sweep in progress
+#define CalFailed 3             // Sweep stopped by a protection fault, old table kept
+
+extern volatile unsigned char CalStatus;
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void CalInit(void);
+
+void CalStart(unsigned char a);
+
+void CalTask(void);
+
+unsigned int CalFeedforward(long rps);
+
+
+#endif	/* CALIB_H */
@@ -0,0 +1,183 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "globals.h"
+#include "telemetry.h"
+#include "sched.h"
+#include "capture.h"
+
+/******************************************************************************/
+/* Capture Variables                                                          */
+/******************************************************************************/
+
+volatile unsigned char CapState;    // CapOff, CapArmed, CapTriggered, CapSending or CapSent
+volatile unsigned char CapOn;       // high_isr records while 1, clears it after the last one
+volatile unsigned char CapHead;     // Ring slot of the next record
+volatile unsigned char CapFull;     // The ring has wrapped: every slot holds a record
+volatile unsigned char CapLeft;     // Records still to store after the trigger, 0 before it
+volatile unsigned char CapTrig;     // Armed triggers, CapTrig bits
+volatile unsigned char CapFired;    // Trigger that fired, CapTrigNow if stopped by command
+volatile unsigned char CapAt;       // Ring slot of the trigger record
+unsigned char CapTick;              // SchedTicks at the last record
+unsigned char CapTimeLo[CapRecords]; // Timer3 at each record, low byte
+unsigned char CapTimeHi[CapRecords]; // ... high byte
+unsigned char CapPins[CapRecords];  // Pins, and ms since the record before in bits 7:4
+
+static unsigned char CapOldest;     // Ring slot of the oldest record of the dump
+static unsigned char CapCount;      // Records in the dump
+static unsigned char CapNext;       // Next dump block, 0 the header
+
+/******************************************************************************/
+/* Capture Functions                                                          */
+/******************************************************************************/
+
+/*******************************
+ * CapInit(void)
+ *
+ * Nothing armed, and Timer3 free running at 1:1 on the instruction clock for
+ * the record times, set up as ProfInit does so either may run it. T3CCP2:1
+ * are left as the sample tick set them. Call before InitInterrupts.
+ *******************************/
+void CapInit(void)
+{
+    CapOn = 0;
+    CapState = CapOff;
+#if CapEnabled
+    T3CONbits.RD16 = 1;                     // 16 bit reads
+    T3CONbits.T3CKPS1 = 0;                  // 1:1 prescaler
+    T3CONbits.T3CKPS0 = 0;                  // ...
+    T3CONbits.TMR3CS = 0;                   // Internal clock
+    T3CONbits.TMR3ON = 1;                   // Turn on Timer3
+#endif
+}
+
+/*******************************
+ * CapSend(void)
+ *
+ * Starts the dump of the ring high_isr has stopped writing: the oldest slot
+ * and the record count are fixed here, and CapTask sends the blocks.
+ *******************************/
+static void CapSend(void)
+{
+    CapOldest = CapFull ? CapHead : 0;
+    CapCount = CapFull ? CapRecords : CapHead;
+    CapNext = 0;
+    CapState = CapSending;
+}
+
+/*******************************
+ * CapArm(unsigned char trig)
+ *
+ * With trig (CapTrig bits) clears the ring and starts recording, waiting for
+ * any of those triggers; a capture in progress is dropped. With 0 stops a
+ * capture in progress at once, as a trigger that stores nothing after it,
+ * and starts the dump. Returns 0 with nothing changed if there is no such
+ * trigger, or nothing to stop, or no capture in this build. Main loop only.
+ *******************************/
+unsigned char CapArm(unsigned char trig)
+{
+#if CapEnabled
+    if ((trig & ~CapTrigAll) != 0)
+    {
+        return 0;
+    }
+    if (trig == 0)
+    {
+        if (CapOn == 0 || (CapHead == 0 && CapFull == 0))
+        {
+            return 0;
+        }
+        INTCONbits.GIEH = 0;                // high_isr may be storing the trigger
+        CapOn = 0;
+        if (CapLeft == 0)
+        {
+            CapFired = CapTrigNow;
+            CapAt = (CapHead - 1) & (CapRecords-1); // The last record
+        }
+        INTCONbits.GIEH = 1;
+        CapSend();
+        return 1;
+    }
+    CapOn = 0;                              // high_isr leaves the ring alone
+    CapHead = 0;
+    CapFull = 0;
+    CapLeft = 0;
+    CapFired = 0;
+    CapTrig = trig;
+    CapTick = SchedTicks;
+    CapState = CapArmed;
+    CapOn = 1;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*******************************
+ * CapTask(void)
+ *
+ * Main loop task, every CapTaskMs. Follows the capture from armed to
+ * triggered to stopped, then sends the header block and one block of
+ * records per run while the telemetry ring has room: the whole ring in
+ * (CapBlocks+1)*CapTaskMs ms.
+ *******************************/
+void CapTask(void)
+{
+    unsigned char buf[TlmBlockData];
+    unsigned char i;
+    unsigned char p;
+    unsigned char r;
+
+    if (CapState == CapArmed && CapLeft != 0)
+    {
+        CapState = CapTriggered;
+    }
+    if ((CapState == CapArmed || CapState == CapTriggered) && CapOn == 0)
+    {
+        CapSend();                          // high_isr stored the last record
+    }
+    if (CapState != CapSending)
+    {
+        return;
+    }
+
+    if (CapNext == 0)
+    {
+        for (i = 0; i < TlmBlockData; i++)
+        {
+            buf[i] = 0;
+        }
+        buf[0] = CapFired;
+        buf[1] = CapCount;
+        buf[2] = (CapAt - CapOldest) & (CapRecords-1);
+        buf[3] = AxisCount;
+    }
+    else
+    {
+        p = (unsigned char)((CapNext - 1) * TlmBlockData); // Dump byte of buf[0]
+        r = p / CapRecordLen;
+        p -= r * CapRecordLen;              // ... its field in the record
+        r = (CapOldest + r) & (CapRecords-1);
+        for (i = 0; i < TlmBlockData; i++)
+        {
+            buf[i] = (p == 0) ? CapTimeLo[r] : (p == 1) ? CapTimeHi[r] : CapPins[r];
+            if (++p == CapRecordLen)
+            {
+                p = 0;
+                r = (r + 1) & (CapRecords-1);
+            }
+        }
+    }
+    if (TlmBlock(CapBlockId + CapNext, buf) != 0)
+    {
+        if (++CapNext > CapBlocks)
+        {
+            CapState = CapSent;
+        }
+    }
+}
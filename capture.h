@@ -0,0 +1,120 @@
+/*
+ * File:   capture.h
+ *
+ * Raw encoder edge capture, to tell a decode fault from a signal fault. While
+ * armed, high_isr stores every RB change interrupt as one record, Timer3 (free
+ * running at 1:1 on the instruction clock, as for ISRProfile) and the pins it
+ * read, in a RAM ring of CapRecords. The first interrupt that matches the
+ * trigger is marked and CapPost more are stored, so the ring holds the edges
+ * before and after it; then recording stops and CapTask sends the ring as
+ * telemetry block frames. tools/edgereplay rebuilds the trace and runs it
+ * through the decoder of encoder.h. Armed by command (CmdCapture). RB change
+ * builds only: the sampled input has no interrupt per edge. While recording,
+ * high_isr takes 82 cycles more per edge (197 with one axis, see main.c), so
+ * one axis keeps every count to about 6 rev/s instead of 9.
+ *
+ * Record, in three byte rings:
+ *   time   Timer3, instruction cycles, wraps every 26.2 ms
+ *   pins   bits 3:0 the pins as HalEncoderPins, bits 7:4 the Timer2 ticks
+ *          (ms) since the record before, 15 for 15 or more; below 15 the
+ *          gap is shorter than one Timer3 wrap
+ *
+ * Dump, block frames CapBlockId, CapBlockId+1, ... (see telemetry.h):
+ *   header 0   trigger that fired, CapTrig bits, CapTrigNow for a command
+ *          1   records, 1..CapRecords
+ *          2   the trigger record, from the oldest
+ *          3   AxisCount
+ *   then the records oldest first, 3 bytes each (time low, time high, pins),
+ *   CapBlocks blocks. No SFR dependencies outside CapRecord, so the layout
+ *   also builds on the host.
+ */
+
+#ifndef CAPTURE_H
+#define	CAPTURE_H
+
+#define CapEnabled (SpeedMode == SpeedEdgeISR && !EncoderSampled)
+
+#define CapRecords 64           // Ring size, power of two
+#define CapPost (CapRecords/2)  // Records stored after the trigger record
+#define CapRecordLen 3          // Bytes per record in the dump
+#define CapBlocks (CapRecords*CapRecordLen/TlmBlockData) // Record blocks after the header
+#define CapBlockId 0x40         // Block number of the header, clear of the log blocks
+#define CapTaskMs 10            // CapTask period, ticks (ms), one block per run
+
+// Triggers, bits of the value of a CmdCapture set
+#define CapTrigIllegal 0x01     // Both channels of an axis changed
+#define CapTrigEmpty 0x02       // No pin changed: an edge and its reverse merged
+#define CapTrigFault 0x04       // A protection fault is latched (from the edge after the trip)
+#define CapTrigAll 0x07
+#define CapTrigNow 0x80         // In the header: stopped by a set to 0
+
+// CapState
+#define CapOff 0                // Nothing captured since reset
+#define CapArmed 1              // Recording, waiting for the trigger
+#define CapTriggered 2          // Recording the CapPost records after it
+#define CapSending 3            // Stopped, the dump is going out
+#define CapSent 4               // Dump sent
+
+#if CapRecords * CapRecordLen != CapBlocks * TlmBlockData
+#error "CapRecords must fill whole block frames"
+#endif
+
+extern volatile unsigned char CapState;
+extern volatile unsigned char CapOn;
+extern volatile unsigned char CapHead;
+extern volatile unsigned char CapFull;
+extern volatile unsigned char CapLeft;
+extern volatile unsigned char CapTrig;
+extern volatile unsigned char CapFired;
+extern volatile unsigned char CapAt;
+extern unsigned char CapTick;
+extern unsigned char CapTimeLo[CapRecords];
+extern unsigned char CapTimeHi[CapRecords];
+extern unsigned char CapPins[CapRecords];
+
+// high_isr, after EncLatch: one record of the interrupt, while CapOn. Before
+// the trigger every record is tested against CapTrig; after it CapLeft counts
+// down to the last one, which turns CapOn off. Byte operations only.
+#if CapEnabled
+#define CapRecord()     do { if (CapOn != 0) { \
+        unsigned char g_ = (unsigned char)(SchedTicks - CapTick); \
+        HalTimer3(CapTimeLo[CapHead], CapTimeHi[CapHead]); \
+        CapTick = SchedTicks; \
+        CapPins[CapHead] = (g_ > 15 ? 0xF0 : (unsigned char)(g_ << 4)) | (EncoderState & 0x0F); \
+        if (CapLeft == 0) \
+        { \
+            g_ = (((EdgeDiff & 0x03) == 0x03 || (EdgeDiff & 0x0C) == 0x0C) ? CapTrigIllegal : 0) | \
+                 (EdgeDiff == 0 ? CapTrigEmpty : 0) | (ProtFault != 0 ? CapTrigFault : 0); \
+            if ((g_ & CapTrig) != 0) \
+            { \
+                CapFired = g_ & CapTrig; \
+                CapAt = CapHead; \
+                CapLeft = CapPost; \
+            } \
+        } \
+        else if (--CapLeft == 0) \
+        { \
+            CapOn = 0; \
+        } \
+        CapHead = (CapHead + 1) & (CapRecords-1); \
+        if (CapHead == 0) \
+        { \
+            CapFull = 1; \
+        } \
+    } } while (0)
+#else
+#define CapRecord()
+#endif
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void CapInit(void);
+
+unsigned char CapArm(unsigned char trig);
+
+void CapTask(void);
+
+
+#endif	/* CAPTURE_H */
@@ -0,0 +1,395 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "globals.h"
+#include "control.h"
+#include "motion.h"
+#include "speed.h"
+#include "profile.h"
+#include "telemetry.h"
+#include "eelog.h"
+#include "protect.h"
+#include "calib.h"
+#include "capture.h"
+#include "command.h"
+
+/******************************************************************************/
+/* Command Variables                                                          */
+/******************************************************************************/
+
+unsigned int CmdErrors;             // Frames with a bad CRC and bytes lost on receive
+volatile unsigned char CmdPending;  // 1: staged by CmdTask, 0: applied by CmdApply
+
+static unsigned char CmdBuf[CmdBufSize];    // Receive ring buffer
+static volatile unsigned char CmdHead;      // Bytes received, written by CmdRx only
+static unsigned char CmdTail;       // Start of the frame being parsed, the bytes before it are free
+static unsigned char CmdScan;       // Next byte to parse
+static unsigned char CmdPos;        // Bytes of the frame seen so far, 0 while looking for CmdSync
+static unsigned char CmdCrc;        // CRC of the frame so far
+static volatile unsigned char CmdLost;  // Bytes lost (ring full, overrun, framing), free running, CmdRx only
+static unsigned char CmdLostSeen;   // CmdLost already added to CmdErrors
+
+// Command staged for CmdApply, written by the main loop only while CmdPending is 0
+static unsigned char CmdCode;       // Parameter, with CmdSet
+static unsigned char CmdAxis;
+static unsigned char CmdStatus;     // Reply status
+static long CmdValue;               // Value to set, the value to reply with once applied
+static long CmdDelta;               // CmdSpeed: the move worked out by MovePlan (CmdApply re-bases it)
+static unsigned long CmdStep;       // ... its phase step
+static unsigned char CmdReplyDue;   // The reply to CmdCode is still to be sent
+
+/******************************************************************************/
+/* Command Functions                                                          */
+/******************************************************************************/
+
+/*******************************
+ * CmdInit(void)
+ *
+ * Empties the receive ring and turns the USART receiver on with its
+ * interrupt as low priority. Call after TlmInit, before InitInterrupts.
+ *******************************/
+void CmdInit(void)
+{
+    CmdHead = 0;
+    CmdTail = 0;
+    CmdScan = 0;
+    CmdPos = 0;
+    CmdLost = 0;
+    CmdLostSeen = 0;
+    CmdErrors = 0;
+    CmdPending = 0;
+    CmdReplyDue = 0;
+
+    RCSTAbits.CREN = 1;                     // Receive on
+    IPR1bits.RCIP = 0;                      // RX as low priority
+    PIE1bits.RCIE = 1;
+}
+
+/*******************************
+ * CmdRx(void)
+ *
+ * Called by the low priority ISR on RCIF. Moves one byte from the receive
+ * FIFO into the ring and nothing else; RCIF stays set while the FIFO holds
+ * another, so that one comes on the next call. A byte with a framing error,
+ * or with the ring full, is counted and dropped. An overrun stops the
+ * receiver and is cleared by turning it off and on.
+ *******************************/
+void CmdRx(void)
+{
+    unsigned char b;
+
+    if (RCSTAbits.FERR)
+    {
+        b = HalRxByte();                    // Reading it clears FERR
+        CmdLost++;
+    }
+    else
+    {
+        b = HalRxByte();
+        if ((unsigned char)(CmdHead - CmdTail) < CmdBufSize)
+        {
+            CmdBuf[CmdHead & (CmdBufSize-1)] = b;
+            CmdHead++;
+        }
+        else
+        {
+            CmdLost++;
+        }
+    }
+    if (RCSTAbits.OERR)
+    {
+        RCSTAbits.CREN = 0;                 // Clear the overrun
+        RCSTAbits.CREN = 1;
+        CmdLost++;
+    }
+}
+
+/*******************************
+ * CmdField(unsigned char i)
+ *
+ * Byte i of the frame being parsed, read in place from the ring.
+ *******************************/
+static unsigned char CmdField(unsigned char i)
+{
+    return CmdBuf[(unsigned char)(CmdTail + i) & (CmdBufSize-1)];
+}
+
+/*******************************
+ * CmdStage(void)
+ *
+ * Checks the frame that has just passed its CRC and stages it for CmdApply,
+ * or stages only the reply if it is refused. The checks and anything the
+ * ISR should not do are done here: the division of a speed move (MovePlan,
+ * which also holds the setpoint until the move starts), the reset of
+ * the counters the main loop owns, the start of a calibration sweep and
+ * the arming of the edge capture.
+ *******************************/
+static void CmdStage(void)
+{
+    long v;
+
+    v = CmdField(6);
+    v = (v << 8) | CmdField(5);
+    v = (v << 8) | CmdField(4);
+    v = (v << 8) | CmdField(3);
+    CmdCode = CmdField(1);
+    CmdAxis = CmdField(2);
+    CmdValue = v;
+    CmdStatus = CmdOk;
+    CmdReplyDue = 1;
+
+    if (CmdAxis >= AxisCount)
+    {
+        CmdStatus = CmdBadAxis;
+        return;
+    }
+    if ((CmdCode == (CmdSpeed | CmdSet) || CmdCode == (CmdDuty | CmdSet) ||
+         CmdCode == (CmdCal | CmdSet)) && ProtFault != 0)
+    {
+        CmdStatus = CmdFaulted;
+        return;
+    }
+    if ((CmdCode == (CmdSpeed | CmdSet) || CmdCode == (CmdDuty | CmdSet) ||
+         CmdCode == (CmdCal | CmdSet)) && CalStatus == CalRunning)
+    {
+        CmdStatus = CmdBusy;
+        return;
+    }
+    switch (CmdCode)
+    {
+        case CmdSpeed | CmdSet:
+            if (v < 0)
+            {
+                CmdStatus = CmdBadValue;
+                return;
+            }
+            CmdStep = MovePlan(CmdAxis, v, &CmdDelta);
+            if (CmdStep == 0)               // More than MoveDeltaMax from the setpoint
+            {
+                CmdStatus = CmdBadValue;
+                return;
+            }
+            break;
+        case CmdDuty | CmdSet:
+            if (v < 0 || v > DutyMax)
+            {
+                CmdStatus = CmdBadValue;
+                return;
+            }
+            break;
+        case CmdKp | CmdSet:
+        case CmdKi | CmdSet:
+            if (v < 0 || v > CmdGainMax)
+            {
+                CmdStatus = CmdBadValue;
+                return;
+            }
+            break;
+        case CmdWindow | CmdSet:
+            if (v < 0 || v > SpeedWinLog2)
+            {
+                CmdStatus = CmdBadValue;
+                return;
+            }
+            break;
+        case CmdStats | CmdSet:
+            TlmDrops = 0;
+            LogDrops = 0;
+            CmdErrors = 0;
+#if ISRProfile
+            ProfReset();
+#endif
+            break;
+        case CmdCal | CmdSet:
+            CalStart(CmdAxis);              // The sweep runs in CalTask
+            break;
+        case CmdCapture | CmdSet:
+            if (v < 0 || v > CapTrigAll || CapArm((unsigned char)v) == 0)
+            {
+                CmdStatus = CmdBadValue;
+                return;
+            }
+            break;
+        case CmdFault | CmdSet:
+        case CmdSpeed:
+        case CmdRPS:
+        case CmdDuty:
+        case CmdKp:
+        case CmdKi:
+        case CmdWindow:
+        case CmdStats:
+        case CmdFault:
+        case CmdCal:
+        case CmdCapture:
+            break;
+        default:
+            CmdStatus = CmdBadParam;
+            return;
+    }
+    CmdPending = 1;                         // Hand over to the sample tick
+}
+
+/*******************************
+ * CmdTask(void)
+ *
+ * Main loop task, every CmdTaskMs. Adds the bytes CmdRx lost to CmdErrors,
+ * sends the reply to the last command once it has been applied, then parses
+ * the new bytes in the ring. Per byte it is one compare while looking for
+ * CmdSync and one CRC table step inside a frame, so the work follows the
+ * byte rate whatever the bytes are. The fields are read in place when the
+ * CRC byte arrives, and the frame's bytes are freed after that. A frame with
+ * a bad CRC is dropped whole, so a real frame that began inside it is lost
+ * too; the host repeats the command. Parsing stops at each command until it
+ * has been applied and answered.
+ *******************************/
+void CmdTask(void)
+{
+    unsigned char b;
+
+    b = CmdLost;
+    CmdErrors += (unsigned char)(b - CmdLostSeen);
+    CmdLostSeen = b;
+
+    if (CmdPending != 0)
+    {
+        return;                             // Not applied yet
+    }
+    if (CmdReplyDue != 0)
+    {
+        if (TlmReply(CmdCode, CmdAxis, CmdStatus, CmdValue) == 0)
+        {
+            return;                         // No room in the telemetry ring: next run
+        }
+        CmdReplyDue = 0;
+    }
+
+    while (CmdScan != CmdHead)
+    {
+        b = CmdBuf[CmdScan & (CmdBufSize-1)];
+        CmdScan++;
+        if (CmdPos == 0)
+        {
+            if (b == CmdSync)
+            {
+                CmdPos = 1;
+                CmdCrc = 0;
+            }
+            else
+            {
+                CmdTail = CmdScan;          // Not in a frame: free the byte
+            }
+        }
+        else if (++CmdPos < CmdFrameLen)
+        {
+            CmdCrc = TlmCrcTable[CmdCrc ^ b];
+        }
+        else
+        {
+            if (b == CmdCrc)
+            {
+                CmdStage();
+            }
+            else
+            {
+                CmdErrors++;
+            }
+            CmdTail = CmdScan;              // Frame done, its bytes are free
+            CmdPos = 0;
+            if (CmdReplyDue != 0)
+            {
+                return;                     // One command at a time
+            }
+        }
+    }
+}
+
+/*******************************
+ * CmdApply(void)
+ *
+ * Called by the low priority ISR at the start of the sample tick while
+ * CmdPending is set. Sets the staged parameter, or reads the one asked for,
+ * into CmdValue for the reply, then releases CmdTask. Only stores and a
+ * bounded window refill (SpeedWindowResize), as the checks and the move
+ * division were done by CmdStage. A speed move is re-based on the setpoint
+ * at this tick, which a fault may have zeroed since MovePlan read it (the
+ * set is then refused with CmdFaulted); only its duration comes from the
+ * plan. The loops and estimators run at the same priority, so they see
+ * either the old value or the new one.
+ *******************************/
+void CmdApply(void)
+{
+    unsigned char a = CmdAxis;
+
+    switch (CmdCode)
+    {
+        case CmdSpeed | CmdSet:
+            if (ProtFault != 0)
+            {
+                CmdStatus = CmdFaulted;     // Tripped since CmdStage: SetRPS is 0 now
+                break;
+            }
+            MoveStart(a, CmdValue - SetRPS[a], CmdStep); // From the setpoint now, not the planned one
+            CtlEnable[a] = 1;
+            break;
+        case CmdSpeed:
+            CmdValue = SetRPS[a];
+            break;
+        case CmdRPS:
+            CmdValue = RPS[a];
+            break;
+        case CmdDuty | CmdSet:
+            ControlHold(a, (unsigned int)CmdValue);
+            break;
+        case CmdDuty:
+            CmdValue = Duty[a];
+            break;
+        case CmdKp | CmdSet:
+            CtlKp = FitInt(CmdValue);
+            break;
+        case CmdKp:
+            CmdValue = CtlKp;
+            break;
+        case CmdKi | CmdSet:
+            CtlKi = FitInt(CmdValue);
+            break;
+        case CmdKi:
+            CmdValue = CtlKi;
+            break;
+        case CmdWindow | CmdSet:
+            SpeedWindowResize((unsigned char)CmdValue);
+            break;
+        case CmdWindow:
+            CmdValue = SpeedWinShift;
+            break;
+        case CmdStats | CmdSet:
+            for (a = 0; a < AxisCount; a++)
+            {
+                EncoderErrors[a] = 0;
+                EncoderMissed[a] = 0;
+            }
+            break;
+        case CmdStats:
+            CmdValue = EncoderErrors[a];
+            break;
+        case CmdFault | CmdSet:
+            ProtClear();
+            break;
+        case CmdFault:
+            CmdValue = ProtFault;
+            break;
+        case CmdCal | CmdSet:
+        case CmdCal:
+            CmdValue = CalStatus;
+            break;
+        case CmdCapture | CmdSet:
+        case CmdCapture:
+            CmdValue = CapState;
+            break;
+    }
+    CmdPending = 0;
+}
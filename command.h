@@ -0,0 +1,102 @@
+/*
+ * File:   command.h
+ *
+ * Runtime commands on the USART (RC7/RX): speed setpoint, duty, gains and
+ * sample window, a reset of the error counters and of a protection fault, the
+ * feedforward calibration and the edge capture, so tuning needs no reflash.
+ * The low priority ISR only moves received bytes into a ring buffer. A main
+ * loop task parses the frames in place in that ring, a constant amount of
+ * work per byte with no copies, and stages one command at a time; the sample
+ * tick applies it (CmdApply), so a change takes effect between two ticks and
+ * never half way through one, and reads the value back for the reply
+ * (TlmReply, see telemetry.h). The frame layout is shared with the host
+ * encoder (tools/cmdsend.c), so this header has no SFR dependencies.
+ *
+ * Command frame, value little endian:
+ *   0      CmdSync
+ *   1      parameter, CmdSet added to set it, otherwise it is read
+ *   2      axis
+ *   3..6   value (ignored when reading)
+ *   7      CRC-8 (poly 0x07, init 0) over bytes 1..6
+ *
+ * Parameters:
+ *   CmdSpeed   speed setpoint, milli-rev/s. A set starts an acceleration
+ *              limited move (as MoveTo) and closes the loop, refused with
+ *              CmdBadValue below 0 or more than MoveDeltaMax from the
+ *              setpoint now; a read gives SetRPS now, part way through a move
+ *   CmdRPS     measured speed, milli-rev/s (read only)
+ *   CmdDuty    duty, 0..DutyMax. A set opens the loop and holds the duty
+ *   CmdKp      proportional gain, Q8, all axes
+ *   CmdKi      integral gain, Q16 per tick, all axes
+ *   CmdWindow  sliding window, 2^value sample ticks, value 0..SpeedWinLog2,
+ *              all axes
+ *   CmdStats   a set clears EncoderErrors, EncoderMissed, TlmDrops, LogDrops,
+ *              CmdErrors (and the ISR profile); a read gives EncoderErrors
+ *   CmdFault   latched protection fault (see protect.h), 0 if none, all
+ *              axes; a set clears it and turns the PWM back on with the loops
+ *              open at zero duty. Speed and duty sets are refused while a
+ *              fault is latched
+ *   CmdCal     feedforward calibration (see calib.h): a set starts a sweep
+ *              of the axis, a read gives CalStatus. Speed and duty sets of
+ *              any axis are refused while it runs, about 10 s
+ *   CmdCapture raw edge capture (see capture.h), all axes: a set with
+ *              CapTrig bits arms it, a set to 0 stops it at once; either way
+ *              the ring is sent as block frames once it stops. A read gives
+ *              CapState. Refused with CmdBadValue where there is nothing to
+ *              stop, and in builds without the RB change input
+ *
+ * Every frame gets one reply. Send the next command after the reply: a
+ * command is staged only once the one before it has been applied and
+ * answered, up to one sample tick later, and the ring holds
+ * CmdBufSize/CmdFrameLen frames meanwhile. A frame with a bad CRC is dropped
+ * with no reply (counted in CmdErrors); repeat a command that got no reply.
+ */
+
+#ifndef COMMAND_H
+#define	COMMAND_H
+
+#define CmdSync 0xC3
+#define CmdFrameLen 8
+#define CmdBufSize 32           // Receive ring bytes, power of two
+#define CmdTaskMs 1             // CmdTask period, ticks (6 bytes arrive per ms at 57600)
+
+// Parameters
+#define CmdSpeed 1
+#define CmdRPS 2
+#define CmdDuty 3
+#define CmdKp 4
+#define CmdKi 5
+#define CmdWindow 6
+#define CmdStats 7
+#define CmdFault 8
+#define CmdCal 9
+#define CmdCapture 10
+#define CmdSet 0x80             // Added to the parameter to set it
+
+// Reply status
+#define CmdOk 0
+#define CmdBadParam 1           // Unknown parameter, or a set of a read only one
+#define CmdBadAxis 2            // No such axis
+#define CmdBadValue 3           // Value out of range, nothing changed
+#define CmdFaulted 4            // A protection fault is latched, clear it first
+#define CmdBusy 5               // A calibration sweep is running
+
+#define CmdGainMax 32767L       // Largest CmdKp, CmdKi
+
+extern unsigned int CmdErrors;  // Frames with a bad CRC and bytes lost on receive
+extern volatile unsigned char CmdPending; // A command is staged for CmdApply
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void CmdInit(void);
+
+void CmdRx(void);
+
+void CmdTask(void);
+
+void CmdApply(void);
+
+
+#endif	/* COMMAND_H */
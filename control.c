@@ -0,0 +1,195 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "globals.h"
+#include "control.h"
+#include "motion.h"
+#include "calib.h"
+
+/******************************************************************************/
+/* Controller Variables                                                       */
+/******************************************************************************/
+
+long SetRPS[AxisCount];         // Speed setpoint (milli-rev/s)
+int CtlKp;                      // Proportional gain (Q8), all axes
+int CtlKi;                      // Integral gain (Q16 per tick), all axes
+unsigned int Duty[AxisCount];   // Last duty written to the PWM (0..DutyMax)
+unsigned char CtlEnable[AxisCount]; // 1: closed loop, 0: hold manual duty
+
+static long CtlInteg[AxisCount];    // Integrator, duty counts in Q16, on top of the feedforward
+static unsigned int CtlManual[AxisCount]; // Duty to hold while the loop is open
+
+/******************************************************************************/
+/* Controller Functions                                                       */
+/******************************************************************************/
+
+/*******************************
+ * WriteDuty(unsigned char a, unsigned int duty)
+ *
+ * Writes the 10-bit duty of axis a to its PWM, CCP1 or CCP2: upper 8 bits in
+ * CCPRxL, lower 2 bits in DCxB1:DCxB0. The hardware latches both at the next
+ * PWM period.
+ *******************************/
+static void WriteDuty(unsigned char a, unsigned int duty)
+{
+#if AxisCount > 1
+    if (a != 0)
+    {
+        HalDuty2(duty);
+    }
+    else
+#endif
+    {
+        HalDuty(duty);
+    }
+    Duty[a] = duty;
+}
+
+/*******************************
+ * ControlInit(void)
+ *
+ * Loads the default gains with a zero setpoint on every axis (main ramps
+ * them to SetRPSInit with MoveTo), preloads the integrators with the start up
+ * duty so the motors start where the old fixed duty left them, and closes
+ * the loops. Call before the Timer2 interrupt is enabled.
+ *******************************/
+void ControlInit(void)
+{
+    unsigned char a;
+
+    CtlKp = CtlKpInit;
+    CtlKi = CtlKiInit;
+    for (a = 0; a < AxisCount; a++)
+    {
+        SetRPS[a] = 0;
+        CtlInteg[a] = (long)DutyInit << 16;
+        CtlManual[a] = DutyInit;
+        WriteDuty(a, DutyInit);
+        CtlEnable[a] = 1;
+    }
+}
+
+/*******************************
+ * SetSpeed(unsigned char a, long rps)
+ *
+ * Sets the speed setpoint of axis a (milli-rev/s) as a step, ending any move
+ * in progress, and closes its loop. Use MoveTo for an acceleration limited
+ * change. Only the Timer2 interrupt is masked while the 4 byte setpoint is
+ * written, so encoder edges are never held off.
+ *******************************/
+void SetSpeed(unsigned char a, long rps)
+{
+    PIE1bits.TMR2IE = 0;                // Hold off ControlTick
+    MoveActive[a] = 0;
+    SetRPS[a] = rps;
+    CtlEnable[a] = 1;
+    PIE1bits.TMR2IE = 1;
+}
+
+/*******************************
+ * ControlHold(unsigned char a, unsigned int duty)
+ *
+ * Opens the loop of axis a and holds duty (clamped to DutyMax) from the next tick. The
+ * integrator is preloaded so closing the loop again at the same setpoint is
+ * bumpless. No masking:
+ * for the low priority ISR (CmdApply); other callers use SetDutyManual.
+ *******************************/
+void ControlHold(unsigned char a, unsigned int duty)
+{
+    if (duty > DutyMax)
+    {
+        duty = DutyMax;
+    }
+    CtlEnable[a] = 0;
+    CtlManual[a] = duty;
+    CtlInteg[a] = ((long)duty << 16) - ((long)CalFeedforward(SetRPS[a]) << 16);
+}
+
+/*******************************
+ * SetDutyManual(unsigned char a, unsigned int duty)
+ *
+ * ControlHold with the Timer2 interrupt masked, so ControlTick never sees
+ * half of it.
+ *******************************/
+void SetDutyManual(unsigned char a, unsigned int duty)
+{
+    PIE1bits.TMR2IE = 0;                // Hold off ControlTick
+    ControlHold(a, duty);
+    PIE1bits.TMR2IE = 1;
+}
+
+/*******************************
+ * ControlTick(unsigned char a)
+ *
+ * Called by the low priority ISR on every Timer2 tick (1 ms) for each axis a.
+ * Runs one step of its PI loop on its latest RPS and writes its duty, the
+ * feedforward for the setpoint (CalFeedforward, 0 without a calibration)
+ * plus the PI terms. The error is clamped to
+ * CtlErrMax so both products fit in a long and the path has no loops, so the
+ * cost per tick is fixed. Anti-windup: the integrator is clamped so that with
+ * the feedforward it stays in the duty range, and is not updated while the
+ * output is saturated in the direction the error would push it.
+ *******************************/
+void ControlTick(unsigned char a)
+{
+    long err;
+    long integ;
+    long out;
+    long ff;
+
+    if (CtlEnable[a] == 0)
+    {
+        WriteDuty(a, CtlManual[a]);
+        return;
+    }
+
+    err = SetRPS[a] - RPS[a];           // Speed error (milli-rev/s)
+    if (err > CtlErrMax)
+    {
+        err = CtlErrMax;
+    }
+    else if (err < -CtlErrMax)
+    {
+        err = -CtlErrMax;
+    }
+
+    ff = CalFeedforward(SetRPS[a]);     // Duty the calibration expects at the setpoint
+    integ = FitLong(CtlInteg[a] + (long)CtlKi * FitInt(err));
+    if (integ > ((DutyMax - ff) << 16)) // Clamp integrator to the duty range
+    {
+        integ = (DutyMax - ff) << 16;
+    }
+    else if (integ < -(ff << 16))
+    {
+        integ = -(ff << 16);
+    }
+
+    out = (FitLong((long)CtlKp * err) >> 8) + (integ >> 16) + ff;
+    if (out > DutyMax)                  // Saturated high: only unwind
+    {
+        out = DutyMax;
+        if (err < 0)
+        {
+            CtlInteg[a] = integ;
+        }
+    }
+    else if (out < 0)                   // Saturated low: only unwind
+    {
+        out = 0;
+        if (err > 0)
+        {
+            CtlInteg[a] = integ;
+        }
+    }
+    else
+    {
+        CtlInteg[a] = integ;
+    }
+
+    WriteDuty(a, (unsigned int)out);
+}
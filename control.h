@@ -0,0 +1,42 @@
+/* 
+ * File:   control.h
+ *
+ * Fixed rate integer PI speed controller, one loop per axis with shared
+ * gains. ControlTick runs from the 1 ms Timer2 tick and writes the full
+ * 10-bit duty of the axis (CCP1, CCP2 for axis 1) from its measured RPS.
+ * make -C sim steps checks the settling time and overshoot of setpoint steps
+ * on the simulator's first order motor.
+ */
+
+#ifndef CONTROL_H
+#define	CONTROL_H
+
+#define DutyMax 624             // 100% duty: 4*(PR2+1) with PR2 = 0x9B
+#define DutyInit 16             // Duty at start up (CCPR1L = 4, DC1B = 0)
+#define SetRPSInit 1000L        // Speed setpoint at start up (milli-rev/s)
+#define CtlKpInit 4             // Proportional gain, duty counts per milli-rev/s, Q8
+#define CtlKiInit 2             // Integral gain, duty counts per milli-rev/s per tick, Q16
+#define CtlErrMax 32767L        // Speed error clamp so gain*error fits in a long
+
+extern long SetRPS[AxisCount];
+extern int CtlKp;
+extern int CtlKi;
+extern unsigned int Duty[AxisCount];
+extern unsigned char CtlEnable[AxisCount];
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void ControlInit(void);
+
+void ControlTick(unsigned char a);
+
+void SetSpeed(unsigned char a, long rps);
+
+void ControlHold(unsigned char a, unsigned int duty);
+
+void SetDutyManual(unsigned char a, unsigned int duty);
+
+
+#endif	/* CONTROL_H */
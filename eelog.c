@@ -0,0 +1,321 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "globals.h"
+#include "snapshot.h"
+#include "telemetry.h"
+#include "eelog.h"
+
+#if LogBlockSize != TlmBlockData
+#error "A log block must fill one telemetry block frame"
+#endif
+
+/******************************************************************************/
+/* Log Variables                                                              */
+/******************************************************************************/
+
+unsigned int LogDrops;              // Records dropped because the write queue was full
+unsigned long LogWrites;            // EEPROM bytes written since reset
+
+static unsigned char LogQAddr[LogQSize];    // Write queue: address
+static unsigned char LogQData[LogQSize];    // ... and data
+static volatile unsigned char LogQHead;     // Entries queued, written by the main loop only
+static volatile unsigned char LogQTail;     // Entries written, written by LogWrite only
+static volatile unsigned char LogBusy;      // A write is in progress or EEIF is pending
+
+static unsigned char LogBlock;      // Block being filled
+static unsigned char LogPos;        // Next free byte in it, 0 when a new block is due
+static unsigned char LogSeq;        // Sequence number of the next block
+static unsigned char LogBoot;       // LogBootFlag until the first block is opened
+static int LogLastR;                // Previous record, for the deltas
+static unsigned char LogLastD;
+
+static unsigned char LogTicks;      // LogTask runs in the current second
+static unsigned int LogSecs;        // Seconds in the sums
+static long LogSumR;                // Sum of the speed samples (milli-rev/s)
+static unsigned long LogSumD;       // Sum of the duty samples
+static unsigned char LogDumpNext;   // Next block to dump, LogBlocks when done
+
+/******************************************************************************/
+/* Log Functions                                                              */
+/******************************************************************************/
+
+static unsigned char LogHeader(unsigned char b)
+{
+    unsigned char h = HalEERead(LogBase + b * LogBlockSize);
+
+    return ((h & ~LogBootFlag) < LogSeqMod) ? h : LogEnd;   // 0x7F/0xFF: never used
+}
+
+/*******************************
+ * LogInit(void)
+ *
+ * Finds the newest block from the sequence numbers in the block headers, so
+ * no pointer has to be kept in a fixed (fast wearing) place, and carries on
+ * after it. The first record after a reset opens a new block marked with
+ * LogBootFlag. A dump of the log is started (see LogDump). EEIF is made a low
+ * priority interrupt. Call before InitInterrupts.
+ *******************************/
+void LogInit(void)
+{
+    unsigned char b;
+    unsigned char h;
+    unsigned char n;
+
+    LogBlock = LogBlocks - 1;           // Blank: the first block will be 0
+    LogSeq = 0;
+    for (b = 0; b < LogBlocks; b++)
+    {
+        h = LogHeader(b);
+        if (h == LogEnd)
+        {
+            continue;
+        }
+        n = LogHeader((b + 1 < LogBlocks) ? b + 1 : 0);
+        h = (unsigned char)((h & ~LogBootFlag) + 1);
+        if (h == LogSeqMod)
+        {
+            h = 0;
+        }
+        if (n == LogEnd || (n & ~LogBootFlag) != h)
+        {
+            LogBlock = b;               // Newest: its successor is older or blank
+            LogSeq = h;
+            break;
+        }
+    }
+    LogPos = 0;
+    LogBoot = LogBootFlag;
+    LogQHead = 0;
+    LogQTail = 0;
+    LogBusy = 0;
+    LogDrops = 0;
+    LogWrites = 0;
+    LogTicks = 0;
+    LogSecs = 0;
+    LogSumR = 0;
+    LogSumD = 0;
+    LogDumpNext = 0;
+
+    PIR2bits.EEIF = 0;
+    IPR2bits.EEIP = 0;                  // EEPROM write done as low priority
+    PIE2bits.EEIE = 1;
+}
+
+/*******************************
+ * LogQueue(unsigned char addr, unsigned char data)
+ *
+ * Adds one byte write to the queue. The entry is complete before LogQHead,
+ * a single byte, moves past it. The caller checked for room.
+ *******************************/
+static void LogQueue(unsigned char addr, unsigned char data)
+{
+    LogQAddr[LogQHead & (LogQSize-1)] = addr;
+    LogQData[LogQHead & (LogQSize-1)] = data;
+    LogQHead++;
+}
+
+/*******************************
+ * LogStart(void)
+ *
+ * Starts the queued writes if LogWrite is idle, by setting EEIF so the ISR
+ * takes the first one.
+ *******************************/
+static void LogStart(void)
+{
+    PIE2bits.EEIE = 0;                  // Hold off LogWrite while checking LogBusy
+    if (LogBusy == 0)
+    {
+        LogBusy = 1;
+        PIR2bits.EEIF = 1;              // Idle: start the first write from the ISR
+    }
+    PIE2bits.EEIE = 1;
+}
+
+/*******************************
+ * LogRecord(int r, unsigned char d)
+ *
+ * Encodes one record (speed r in LogRPSUnit, duty d in Duty/4) and queues
+ * its bytes, followed by LogEnd unless the block is then full. A record that
+ * does not fit in the block, and the first one after a reset, open the next
+ * block: its header and an absolute record overwrite the oldest block. At
+ * most 6 bytes are queued, so a full queue drops the whole record.
+ *******************************/
+static void LogRecord(int r, unsigned char d)
+{
+    unsigned char rec[4];
+    unsigned char n;
+    unsigned char addr;
+    unsigned char i;
+    long dr = (long)r - LogLastR;       // Both ends of the int range apart: no int wrap
+    int dd = (int)d - LogLastD;
+
+    if ((unsigned char)(LogQSize - (unsigned char)(LogQHead - LogQTail)) < 6)
+    {
+        LogDrops++;
+        return;
+    }
+
+    if (dr >= -8 && dr <= 7 && dd >= -4 && dd <= 3)
+    {
+        rec[0] = (unsigned char)(((dr & 0x0F) << 3) | (dd & 0x07));
+        n = 1;
+    }
+    else if (dr >= -128 && dr <= 127 && dd >= -32 && dd <= 31)
+    {
+        rec[0] = (unsigned char)(LogMid | (dd & 0x3F));
+        rec[1] = (unsigned char)dr;
+        n = 2;
+    }
+    else
+    {
+        n = 4;
+    }
+    if (LogPos == 0 || LogPos + n > LogBlockSize)
+    {
+        LogBlock = (LogBlock + 1 < LogBlocks) ? LogBlock + 1 : 0;
+        LogQueue(LogBase + LogBlock * LogBlockSize, LogSeq | LogBoot);
+        LogSeq = (LogSeq + 1 < LogSeqMod) ? LogSeq + 1 : 0;
+        LogBoot = 0;
+        LogPos = 1;
+        n = 4;                          // A block starts with an absolute record
+    }
+    if (n == 4)
+    {
+        rec[0] = LogAbs;
+        rec[1] = (unsigned char)r;
+        rec[2] = (unsigned char)((unsigned int)r >> 8);
+        rec[3] = d;
+    }
+
+    addr = LogBase + LogBlock * LogBlockSize + LogPos;
+    for (i = 0; i < n; i++)
+    {
+        LogQueue(addr + i, rec[i]);
+    }
+    LogPos += n;
+    if (LogPos < LogBlockSize)
+    {
+        LogQueue(addr + n, LogEnd);
+    }
+    LogLastR = r;
+    LogLastD = d;
+    LogStart();
+}
+
+/*******************************
+ * LogPut(unsigned char addr, unsigned char data)
+ *
+ * Queues a write of one byte outside the log (settings, from 0xC0) and
+ * starts the writes if they are idle. Room for one record (6 bytes) is kept
+ * for LogRecord, so settings never make it drop one. Returns 0, with nothing
+ * queued, when there is no room; try again on a later run. Main loop only.
+ *******************************/
+unsigned char LogPut(unsigned char addr, unsigned char data)
+{
+    if ((unsigned char)(LogQSize - (unsigned char)(LogQHead - LogQTail)) <= 6)
+    {
+        return 0;
+    }
+    LogQueue(addr, data);
+    LogStart();
+    return 1;
+}
+
+/*******************************
+ * LogTask(void)
+ *
+ * Main loop task, every LogTaskMs. Sends the next block of a dump in
+ * progress, and once a second adds the speed and duty from the snapshot to
+ * the sums. Every LogPeriodSec seconds the means become a record. The one
+ * division per record is done here.
+ *******************************/
+void LogTask(void)
+{
+    SpeedSnap Snap;
+    long r;
+
+    LogDump();
+    if (++LogTicks < 1000 / LogTaskMs)
+    {
+        return;
+    }
+    LogTicks = 0;
+
+    SnapRead(&Snap);
+    LogSumR += Snap.RPS[0];             // Axis 0
+    LogSumD += Snap.Duty[0];
+    if (++LogSecs < LogPeriodSec)
+    {
+        return;
+    }
+
+    r = LogSumR / (long)(LogPeriodSec * LogRPSUnit);
+    if (r > 32767)
+    {
+        r = 32767;
+    }
+    else if (r < -32767)
+    {
+        r = -32767;
+    }
+    LogRecord(FitInt(r), (unsigned char)(LogSumD / (LogPeriodSec * 4UL)));
+    LogSecs = 0;
+    LogSumR = 0;
+    LogSumD = 0;
+}
+
+/*******************************
+ * LogDump(void)
+ *
+ * Sends the next block of a log dump in progress as a telemetry block frame
+ * (block number as the id) if the telemetry ring has room. EEPROM reads
+ * take a cycle, so with one block per LogTask run the whole log goes out in
+ * 120 ms, and the ring still has room for the telemetry samples. Started by
+ * LogInit after every reset.
+ *******************************/
+void LogDump(void)
+{
+    unsigned char buf[LogBlockSize];
+    unsigned char i;
+    unsigned char addr;
+
+    if (LogDumpNext >= LogBlocks)
+    {
+        return;
+    }
+    addr = LogBase + LogDumpNext * LogBlockSize;
+    for (i = 0; i < LogBlockSize; i++)
+    {
+        buf[i] = HalEERead(addr + i);
+    }
+    if (TlmBlock(LogDumpNext, buf) != 0)
+    {
+        LogDumpNext++;                  // Otherwise the same block next run
+    }
+}
+
+/*******************************
+ * LogWrite(void)
+ *
+ * Called by the low priority ISR on EEIF, set by the hardware when a write
+ * has finished, or by LogRecord to start from idle. Starts the next queued
+ * write, or goes idle when the queue is empty. The write cycle itself runs
+ * in the background; nothing polls WR.
+ *******************************/
+void LogWrite(void)
+{
+    if (LogQTail == LogQHead)
+    {
+        LogBusy = 0;
+        return;
+    }
+    HalEEWrite(LogQAddr[LogQTail & (LogQSize-1)], LogQData[LogQTail & (LogQSize-1)]);
+    LogQTail++;
+    LogWrites++;
+}
@@ -0,0 +1,65 @@
+/*
+ * File:   eelog.h
+ *
+ * Speed history in the data EEPROM, kept across power cycles. Once a second
+ * the main loop adds the speed and duty of axis 0 to a running sum; every
+ * LogPeriodSec the means are stored as one record, a delta from the previous
+ * record in one or two bytes when it is small. The region is a ring of blocks written
+ * in turn, so every byte wears at the same rate. The bytes to write are
+ * queued and written one per EEIF interrupt, so nothing waits on the 4 ms
+ * write cycle. The layout is shared with the host decoder (tools/logdecode.c),
+ * so this header has no SFR dependencies.
+ *
+ * Block of LogBlockSize bytes:
+ *   0      header: sequence number 0..LogSeqMod-1, LogBootFlag set in the
+ *          first block after a reset; 0xFF (blank) if never used
+ *   1..4   LogAbs record
+ *   ...    records, then LogEnd if the block is not full
+ *
+ * Records (speed r in LogRPSUnit milli-rev/s, duty d in Duty/4):
+ *   0rrrrddd               delta, r -8..7, d -4..3
+ *   10dddddd rrrrrrrr      delta, d -32..31, r -128..127
+ *   110xxxxx rl rh d       absolute, r little endian
+ *   11111111               LogEnd
+ * The newest block is the one whose successor does not carry the next
+ * sequence number; the oldest is the one after it.
+ */
+
+#ifndef EELOG_H
+#define	EELOG_H
+
+#define LogBase 0x00            // EEPROM address of block 0
+#define LogBlockSize 16         // Bytes per block (one telemetry block frame)
+#define LogBlocks 12            // 192 bytes; 0xC0..0xFF are left for settings (LogPut)
+#define LogSeqMod 127           // Sequence numbers 0..126 (with LogBootFlag never 0xFF)
+#define LogBootFlag 0x80
+#define LogEnd 0xFF             // Blank byte, end of the records in a block
+#define LogAbs 0xC0             // Absolute record
+#define LogMid 0x80             // Two byte delta record
+#define LogRPSUnit 10           // Stored speed unit (milli-rev/s)
+
+#define LogTaskMs 10            // LogTask period, ticks (ms)
+#ifndef LogPeriodSec
+#define LogPeriodSec 1800       // Seconds averaged into a record: about 2.5 days in 12 blocks
+#endif
+#define LogQSize 8              // Queued EEPROM byte writes, power of two
+
+extern unsigned int LogDrops;   // Records dropped because the write queue was full
+extern unsigned long LogWrites; // EEPROM bytes written since reset
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void LogInit(void);
+
+void LogTask(void);
+
+void LogDump(void);
+
+void LogWrite(void);
+
+unsigned char LogPut(unsigned char addr, unsigned char data);
+
+
+#endif	/* EELOG_H */
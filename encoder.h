@@ -0,0 +1,120 @@
+/*
+ * File:   encoder.h
+ *
+ * Quadrature decode of SpeedEdgeISR, one pin sample at a time. high_isr
+ * expands these in place (no call, no stack), and tools/edgereplay expands
+ * the same text over captured edges (see capture.h), so what the host replays
+ * is what the firmware runs. pins is the encoder bits as HalEncoderPins
+ * gives them, A in bit 2a+1 and B in bit 2a of axis a.
+ *
+ * The bit tests replace the packed 16 entry QEM table that ReadEncoder
+ * indexed when it decoded at low priority. Counted by hand on the PIC18
+ * sequences, per axis: the table takes 9 cycles to build old*4+new, 10 to
+ * load TBLPTR and read the entry, 6 to branch on it, 25 in all; the tests
+ * here take 16 for the same three outcomes, none of them a table read, and
+ * the second axis shares the one EdgeDiff. tools/quadcheck runs every
+ * transition of each axis against the table (table case), and
+ * tools/edgereplay still replays captures through it (qem variant).
+ *
+ *   EncLatch(pins)   RB change: shift pins in under the last ones
+ *   EncFilter(pins)  EncoderSampled: pass pins through the glitch filter,
+ *                    then shift in the filtered levels
+ *   EncDecode()      count each axis whose pair changed in EdgeUp,
+ *                    EdgeDown or EdgeIllegal, and take it off its
+ *                    protection budget (ProtEdges, ProtIllegal)
+ *
+ * Every RB change interrupt takes one off ProtEdges, and the one that empties
+ * it also masks RB change until ProtTick refills the budget on the next Timer2
+ * tick. Past what high_isr can take, the edges would otherwise hold the CPU
+ * for good and the low priority ISR (ticks, loops, commands) would never run
+ * again; masked, the low ISR gets the rest of the tick, and the edges it
+ * spans are lost (the first one after is mostly illegal, in EncoderMissed).
+ *
+ * The globals they work on are declared in globals.h and protect.h.
+ */
+
+#ifndef ENCODER_H
+#define	ENCODER_H
+
+// One off axis a's edge budget. The edge that empties it cuts the PWM, and
+// with RB change masks it for the rest of the tick.
+#if EncoderSampled
+#define EncEdgesOff()                   /* Timer0 paces the samples itself */
+#else
+#define EncEdgesOff()   HalEdgeIntOff()
+#endif
+#define EncSpend(a) \
+        if (--ProtEdges[a] == 0) \
+        { \
+            ProtTrip(ProtAxis(a) | ProtOverspeed); /* Edge budget of this tick used up */ \
+            EncEdgesOff();              /* ... and the rest of the tick to the low ISR */ \
+        }
+
+// EncoderState holds old*16+new, EdgeDiff the channels that changed. An
+// interrupt where nothing changed means an edge and its reverse were merged,
+// which is what a shaft past high_isr mostly gives: axis 0 pays for it.
+#define EncLatch(pins)  do { \
+        EncoderState = (unsigned char)(EncoderState << 4) | (pins); \
+        EdgeDiff = (unsigned char)((EncoderState >> 4) ^ EncoderState) & AxisPinMask; \
+        if (EdgeDiff == 0) \
+        { \
+            EdgeNone++; \
+            EncSpend(0) \
+        } \
+    } while (0)
+
+// Vertical counters: EncCnt2:EncCnt1:EncCnt0 count the samples in a row each
+// pin has differed from EncFilt; a pin that reaches EncFilterN takes its new
+// level and shows in EdgeDiff.
+#define EncFilter(pins) do { \
+        EdgeDiff = (pins) ^ EncFilt;    /* Pins that differ from the filtered level */ \
+        EncCnt2 ^= EncCnt1 & EncCnt0;   /* Count those up... */ \
+        EncCnt1 ^= EncCnt0; \
+        EncCnt0 = (unsigned char)~EncCnt0; \
+        EncCnt0 &= EdgeDiff;            /* ... and the others back to 0 */ \
+        EncCnt1 &= EdgeDiff; \
+        EncCnt2 &= EdgeDiff; \
+        EdgeDiff &= ((EncFilterN & 1) ? EncCnt0 : ~EncCnt0) & /* Counts that reached EncFilterN */ \
+                    ((EncFilterN & 2) ? EncCnt1 : ~EncCnt1) & \
+                    ((EncFilterN & 4) ? EncCnt2 : ~EncCnt2); \
+        EncCnt0 &= ~EdgeDiff;           /* Those pass: new level, count from 0 */ \
+        EncCnt1 &= ~EdgeDiff; \
+        EncCnt2 &= ~EdgeDiff; \
+        EncFilt ^= EdgeDiff; \
+        EncoderState = (unsigned char)(EncoderState << 4) | EncFilt; \
+    } while (0)
+
+// Axis a, channel pair m (0x03 or 0x0C). Both changed: at least one edge was
+// missed. One changed: old A == new B is CW (+1), otherwise CCW. Either one
+// costs high_isr the same, so both take it off the edge budget (EncSpend).
+// The illegal transition that empties ProtIllegal cuts the PWM.
+#define EncDecodeAxis(a, m) \
+        if ((EdgeDiff & (m)) != 0) \
+        { \
+            if ((EdgeDiff & (m)) == (m)) \
+            { \
+                EdgeIllegal[a]++; \
+                if (--ProtIllegal[a] == 0) \
+                { \
+                    ProtTrip(ProtAxis(a) | ProtEncoder); /* Too many: the encoder is lost */ \
+                } \
+            } \
+            else if ((EncoderState ^ (EncoderState >> 5)) & (m) & 0x05) \
+            { \
+                EdgeDown[a]++; \
+            } \
+            else \
+            { \
+                EdgeUp[a]++; \
+            } \
+            EncSpend(a) \
+        }
+
+#if AxisCount > 1
+#define EncDecode()     do { EncDecodeAxis(0, 0x03) EncDecodeAxis(1, 0x0C) } while (0)
+#else
+#define EncDecode()     do { EncDecodeAxis(0, 0x03) } while (0)
+#endif
+
+
+#endif	/* ENCODER_H */
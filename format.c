@@ -0,0 +1,125 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include "format.h"
+
+/******************************************************************************/
+/* Format Functions                                                           */
+/******************************************************************************/
+
+static const unsigned long Pow10[] = {1UL,10UL,100UL,1000UL,10000UL,100000UL,
+                                      1000000UL,10000000UL,100000000UL,1000000000UL};
+
+/*******************************
+ * FormatDigits(char * end, unsigned long mag, unsigned char dec, char neg)
+ *
+ * Writes mag as decimal digits backwards from end, with a '.' placed dec
+ * digits from the right and at least one digit before it. Returns a pointer
+ * to the first character.
+ *******************************/
+static char * FormatDigits(char * end, unsigned long mag, unsigned char dec, char neg)
+{
+    unsigned char n = 0;
+
+    do
+    {
+        *--end = (char)('0' + (unsigned char)(mag % 10));
+        mag /= 10;
+        n++;
+        if (n == dec)
+        {
+            *--end = '.';
+        }
+    } while (mag != 0 || n <= dec);
+
+    if (neg)
+    {
+        *--end = '-';
+    }
+    return end;
+}
+
+/*******************************
+ * FormatFixed(char * buf, long var, unsigned char scale, unsigned char width,
+ *             unsigned char prec, char over)
+ *
+ * Formats the fixed point value var (scale decimal digits, e.g. scale = 3 for
+ * milli-units) right aligned in exactly width characters and zero terminates
+ * buf, which must hold width+1 bytes. Up to prec decimals are shown, rounded;
+ * decimals are dropped one at a time when the number would not fit, the same
+ * way the old "%*.*g" kept the field width. If even the integer part does not
+ * fit, the whole field is the overflow marker over, so no digits are shown
+ * that could be read as a value. Returns the number of characters written
+ * (width).
+ *******************************/
+int FormatFixed(char * buf, long var, unsigned char scale, unsigned char width,
+                unsigned char prec, char over)
+{
+    char tmp[FormatMax];
+    char * p;
+    unsigned long mag;
+    unsigned long rounded;
+    unsigned char dec;
+    unsigned char len;
+    unsigned char i;
+
+    if (width == 0)
+    {
+        buf[0] = '\0';
+        return 0;
+    }
+    if (scale > 9)                      // Keep within the Pow10 table
+    {
+        scale = 9;
+    }
+    mag = (var < 0) ? (unsigned long)(-(var+1)) + 1 : (unsigned long)var;
+    dec = (prec < scale) ? prec : scale;
+
+    while (1)
+    {
+        rounded = mag;                  // Round off the digits not shown
+        if (dec < scale)
+        {
+            rounded = (mag + Pow10[scale-dec]/2) / Pow10[scale-dec];
+        }
+        p = FormatDigits(tmp+FormatMax, rounded, dec, (char)(var < 0 && rounded != 0));
+        len = (unsigned char)(tmp+FormatMax - p);
+        if (len <= width || dec == 0)
+        {
+            break;
+        }
+        dec--;                          // Drop a decimal and try again
+    }
+
+    if (len <= width)                   // Right align in the field
+    {
+        for (i = 0; i < width-len; i++)
+        {
+            buf[i] = ' ';
+        }
+        for (; i < width; i++)
+        {
+            buf[i] = *p++;
+        }
+    }
+    else                                // Too large: mark overflow
+    {
+        for (i = 0; i < width; i++)
+        {
+            buf[i] = over;
+        }
+    }
+    buf[i] = '\0';
+    return width;
+}
+
+/*******************************
+ * FormatInt(char * buf, long var, unsigned char width, char over)
+ *
+ * Formats the integer var right aligned in width characters, see FormatFixed.
+ *******************************/
+int FormatInt(char * buf, long var, unsigned char width, char over)
+{
+    return FormatFixed(buf, var, 0, width, 0, over);
+}
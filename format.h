@@ -0,0 +1,24 @@
+/* 
+ * File:   format.h
+ *
+ * Small right aligned decimal formatter for signed integers and fixed point
+ * values. Replaces sprintf so the float and long-long printf helpers are not
+ * linked in. Has no SFR dependencies so it also builds on the host.
+ */
+
+#ifndef FORMAT_H
+#define	FORMAT_H
+
+#define FormatMax 12            // Longest rendered number (sign, 10 digits, '.')
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+int FormatFixed(char * buf, long var, unsigned char scale, unsigned char width,
+                unsigned char prec, char over);
+
+int FormatInt(char * buf, long var, unsigned char width, char over);
+
+
+#endif	/* FORMAT_H */
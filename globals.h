@@ -8,19 +8,116 @@
 #ifndef GLOBALS_H
 #define	GLOBALS_H
 
-extern int CHA;
-extern int CHB;
-extern int OLD_ROT;
-extern int CCWTurn;
-extern int CWTurn;
-extern const int CountPerRev;
-extern const int EncoderPoll;
-extern double PartialRot;
-extern double RPS;
-extern const int QEM[16];
-extern int CHAcount;
+#define RPSScale 1000L      // RPS is held in fixed point as milli-rev/s
+#define RPSDigits 3         // Decimal digits in RPSScale
+
+#define EncoderLines 500    // Encoder lines per revolution (based on encoder specs)
+#define EncoderCPR (4*EncoderLines) // Total counts per revolution with 4x quadrature decoding
+
+// Speed measurement mode, select with SpeedMode (e.g. -DSpeedMode=1)
+#define SpeedEdgeISR 0      // Decode every encoder edge in the RB-change interrupt (4x, with direction)
+#define SpeedTimer1 1       // Channel A also wired to T13CKI (RC0), Timer1 counts rising edges (1x, no direction)
+#define SpeedMT 2           // Channel A also wired to CCP2 (RC1), edges timed on Timer3, M/T speed every tick
+#ifndef SpeedMode
+#define SpeedMode SpeedEdgeISR
+#endif
+
+// Encoder input of SpeedEdgeISR, select with EncoderSampled (e.g.
+// -DEncoderSampled=1). 0: high_isr runs on every RB change, so a bouncing or
+// noisy encoder costs an interrupt per glitch. 1: the RB change interrupt is
+// off and Timer0 (8 bit, free running) interrupts every EncSampleCycles;
+// high_isr samples the pins through a glitch filter per channel, where a new
+// level passes once EncFilterN samples in a row have shown it. The CPU load
+// is then about the same whatever the pins do: high_isr takes 46% to 48% at
+// EncSampleLog2 0, where RB change takes 9.2% per rev/s and more per
+// glitch. A channel level must last EncFilterN samples and the A and B
+// edges must fall on different samples, so the top speed is one edge per
+// max(1,EncFilterN/2) samples: 4.9 rev/s at EncFilterN 2, 3.3 at 3. Well
+// below that, glitches shorter than EncFilterN-1 samples are dropped whole;
+// close to it, a glitch that delays one edge by a sample can merge it with
+// the next (an illegal transition), so counts are lost at about the RB
+// change rate but still at a fixed load (make -C sim chatter compares the
+// two inputs).
+#ifndef EncoderSampled
+#define EncoderSampled 0
+#endif
+#ifndef EncFilterN
+#define EncFilterN 2        // Samples a new level must be seen on, 1 (no filter) to 7
+#endif
+#ifndef EncSampleLog2
+#define EncSampleLog2 0     // Timer0 prescale 1:2^EncSampleLog2, 0..8
+#endif
+#define EncSampleCycles (256L << EncSampleLog2) // Instruction cycles per sample (102.4 us)
+#if EncFilterN < 1 || EncFilterN > 7
+#error "EncFilterN must be 1..7 (3 bit counters)"
+#endif
+#if EncSampleLog2 < 0 || EncSampleLog2 > 8
+#error "EncSampleLog2 must be 0..8"
+#endif
 
-extern int TMR0count;
+// Axes (motor, encoder, PWM), select with AxisCount (e.g. -DAxisCount=2). Per
+// axis state is kept as arrays indexed by axis, one array per quantity.
+// Axis 0: encoder A/B on RB5/RB4, PWM on CCP1 (RC2). Axis 1: encoder A/B on
+// RB7/RB6 (also the ICSP PGD/PGC pins), PWM on CCP2 (RC1, CCP2MUX = ON).
+// Both encoders share high_isr, so they share its edge rate: with both
+// turning each axis reads true to 4 rev/s, against 9 for one axis, and the
+// overspeed limit is 4 rev/s instead of 8 (protect.h; make -C sim sweep
+// DEFS=-DAxisCount=2).
+#ifndef AxisCount
+#define AxisCount 1
+#endif
+#if AxisCount < 1 || AxisCount > 2
+#error "AxisCount must be 1 or 2"
+#endif
+#if AxisCount > 1 && SpeedMode != SpeedEdgeISR
+#error "Two axes need SpeedEdgeISR: Timer1 and CCP2 serve only one encoder"
+#endif
+#if EncoderSampled && (SpeedMode != SpeedEdgeISR || AxisCount > 1)
+#error "EncoderSampled needs SpeedEdgeISR with one axis: the others take Timer0 for the sample tick"
+#endif
+#define AxisPinMask ((1 << (2*AxisCount)) - 1) // Encoder bits of PORTB >> 4
+
+// Narrowing to XC8's 16 bit int and 32 bit long, where the math counts on the
+// value fitting. The host build (sim/, the tools) has a 32 bit int and a 64
+// bit long, so an overflow there would go unseen: with SIM the value is
+// checked and the run aborts on one that the PIC would wrap.
+#ifdef SIM
+#include <stdio.h>
+#include <stdlib.h>
+static inline long long FitCheck(long long v, long long lo, long long hi, const char * file, int line)
+{
+    if (v < lo || v > hi)
+    {
+        fprintf(stderr, "%s:%d: %lld does not fit %lld..%lld\n", file, line, v, lo, hi);
+        abort();
+    }
+    return v;
+}
+#define FitInt(x)   ((int)FitCheck((long long)(x), -32768LL, 32767LL, __FILE__, __LINE__))
+#define FitLong(x)  ((long)FitCheck((long long)(x), -2147483647LL-1, 2147483647LL, __FILE__, __LINE__))
+#else
+#define FitInt(x)   ((int)(x))
+#define FitLong(x)  ((long)(x))
+#endif
+
+extern unsigned char EncoderState;
+extern long EncoderPos[AxisCount];
+extern long EncoderLastPos[AxisCount];
+extern unsigned int EncoderErrors[AxisCount];
+extern unsigned int EncoderMissed[AxisCount];
+extern volatile unsigned char EdgeUp[AxisCount];
+extern volatile unsigned char EdgeDown[AxisCount];
+extern volatile unsigned char EdgeIllegal[AxisCount];
+extern volatile unsigned char EdgeNone;
+extern unsigned char EdgeDiff;
+extern unsigned char EncFilt;
+extern unsigned char EncCnt0;
+extern unsigned char EncCnt1;
+extern unsigned char EncCnt2;
+extern unsigned int PulseLast;
+extern const int CountPerRev;
+extern long RPS[AxisCount];
+extern long CHAcount[AxisCount];
 
 
 #endif	/* GLOBALS_H */
@@ -0,0 +1,118 @@
+/* 
+ * File:   hal.h
+ *
+ * Thin hardware abstraction for the I/O the application logic touches at run
+ * time (encoder pins, LCD bus, LEDs, PWM duties, capture, USART, data EEPROM).
+ * On the PIC these are plain SFR accesses. The host build (sim/, -DSIM)
+ * compiles the same sources against a simulated SFR image; accessors with
+ * side effects the simulator has to see (the LCD strobe, a TXREG write or
+ * RCREG read, an EEPROM access) call into the simulator instead. Peripheral set up in
+ * InitApp/InitInterrupts still writes the SFRs directly.
+ */
+
+#ifndef HAL_H
+#define	HAL_H
+
+#ifdef SIM
+#include "sim.h"
+#endif
+
+// Encoders: axis 0 channel A on RB5, B on RB4; axis 1 A on RB7, B on RB6
+#define HalEncoderPins()    ((PORTB >> 4) & AxisPinMask) // Per axis A in bit 2a+1, B in bit 2a
+#define HalEncoderB()       (PORTBbits.RB4)
+
+// RB change interrupt off and back on. Off, RBIF still latches a mismatch, so
+// the interrupt comes as soon as it is back on. One BCF, for high_isr.
+#define HalEdgeIntOff()     (INTCONbits.RBIE = 0)
+#define HalEdgeIntOn()      (INTCONbits.RBIE = 1)
+
+// LCD: data on RD7:RD4, RS on RE0, E on RE1
+#ifdef SIM
+#define HalLCDNibble(rs,nib) SimLCDNibble((rs),(nib))
+#else
+#define HalLCDNibble(rs,nib) do { PORTEbits.RE0 = (rs); PORTEbits.RE1 = 1; \
+                                  PORTD = (nib); PORTEbits.RE1 = 0; } while (0)
+#endif
+
+// Direction LEDs
+#define HalLEDCW(on)        (PORTAbits.RA3 = (on))
+#define HalLEDCCW(on)       (PORTAbits.RA2 = (on))
+
+// CCP1 PWM duty, 10 bits: CCPR1L holds bits 9:2, DC1B1:DC1B0 bits 1:0
+#define HalDuty(d)          do { CCPR1L = (unsigned char)((d) >> 2); \
+                                 CCP1CONbits.DC1B1 = ((d) >> 1) & 1; \
+                                 CCP1CONbits.DC1B0 = (d) & 1; } while (0)
+
+// CCP2 PWM duty (axis 1), same layout
+#define HalDuty2(d)         do { CCPR2L = (unsigned char)((d) >> 2); \
+                                 CCP2CONbits.DC2B1 = ((d) >> 1) & 1; \
+                                 CCP2CONbits.DC2B0 = (d) & 1; } while (0)
+
+// PWM outputs off and back on (CCPxM3:CCPxM0 = 0000 and 1100). Off, the pins
+// follow their port latches. A single AND, so high_isr can use it.
+#if AxisCount > 1
+#define HalPWMOff()         do { CCP1CON &= 0xF0; CCP2CON &= 0xF0; } while (0)
+#define HalPWMOn()          do { CCP1CON |= 0x0C; CCP2CON |= 0x0C; } while (0)
+#else
+#define HalPWMOff()         (CCP1CON &= 0xF0)
+#define HalPWMOn()          (CCP1CON |= 0x0C)
+#endif
+
+// USART transmit register, and the receive FIFO (reading it pops a byte and
+// clears RCIF when the FIFO is empty)
+#ifdef SIM
+#define HalTxByte(b)        SimTxByte(b)
+#define HalRxByte()         SimRxByte()
+#else
+#define HalTxByte(b)        (TXREG = (b))
+#define HalRxByte()         (RCREG)
+#endif
+
+// Main loop idle wait. The PIC18F452 has no IDLE mode and SLEEP would stop
+// Timer2, so on the chip this only passes time; the simulator skips ahead
+// to the next interrupt.
+#ifdef SIM
+#define HalIdle()           SimSleep()
+#else
+#define HalIdle()           NOP()
+#endif
+
+// CCP2 captured Timer3 value
+#define HalCapture2()       (((unsigned int)CCPR2H << 8) | CCPR2L)
+
+// Timer2 count, 0..PR2, one step per 16 instruction cycles (1:16 prescaler)
+#ifdef SIM
+#define HalTimer2()         SimTimer2()
+#else
+#define HalTimer2()         (TMR2)
+#endif
+
+// Timer3 as two bytes, low first: reading TMR3L latches TMR3H (RD16), so the
+// pair is from one instant. No call, so high_isr can use it.
+#ifdef SIM
+#define HalTimer3(lo,hi)    do { unsigned int t3_ = ReadTimer3(); (lo) = (unsigned char)t3_; \
+                                 (hi) = (unsigned char)(t3_ >> 8); } while (0)
+#else
+#define HalTimer3(lo,hi)    do { (lo) = TMR3L; (hi) = TMR3H; } while (0)
+#endif
+
+// Data EEPROM. A read takes one cycle. HalEEWrite starts a write of d at a,
+// which takes about 4 ms and sets EEIF when done; do not start another one
+// before that. The 0x55/0xAA unlock must run uninterrupted, so all interrupts
+// are held off for those few instructions.
+#ifdef SIM
+#define HalEERead(a)        SimEERead(a)
+#define HalEEWrite(a,d)     SimEEWrite((a),(d))
+#else
+#define HalEERead(a)        (EEADR = (a), EECON1bits.EEPGD = 0, EECON1bits.CFGS = 0, \
+                             EECON1bits.RD = 1, EEDATA)
+#define HalEEWrite(a,d)     do { unsigned char gieh_ = INTCONbits.GIEH; \
+                                 EEADR = (a); EEDATA = (d); \
+                                 EECON1bits.EEPGD = 0; EECON1bits.CFGS = 0; \
+                                 EECON1bits.WREN = 1; INTCONbits.GIEH = 0; \
+                                 EECON2 = 0x55; EECON2 = 0xAA; EECON1bits.WR = 1; \
+                                 INTCONbits.GIEH = gieh_; EECON1bits.WREN = 0; } while (0)
+#endif
+
+
+#endif	/* HAL_H */
@@ -0,0 +1,236 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "lcd.h"
+
+/******************************************************************************/
+/* LCD States and Variables                                                   */
+/******************************************************************************/
+
+#define LCDPowerUp  0       // Waiting for the LCD to come out of reset
+#define LCDInitSeq  1       // Sending the init string
+#define LCDIdle     2       // Looking for a cell that changed
+#define LCDChar     3       // Cursor positioned, send the pending cell
+#define LCDSendLow  4       // High nibble sent, low nibble next
+
+#define LCDCursorLost 0xFF  // LCD cursor position unknown
+
+static volatile char LCDFrame[LCDCells];    // What the application wants shown
+static char LCDShown[LCDCells];             // What the LCD is currently showing
+static char LCDInitStr[LCDInitMax];         // Copy of the init string
+static volatile unsigned char LCDDirty;     // Set by writers when the frame changes
+static unsigned char LCDState;              // Current driver state
+static unsigned char LCDNext;               // State to enter after the low nibble
+static unsigned char LCDWait;               // Ticks left before the next nibble
+static unsigned char LCDHold;               // Ticks to hold after the low nibble
+static unsigned char LCDByte;               // Byte being sent
+static unsigned char LCDRS;                 // RS level for the byte being sent
+static unsigned char LCDIndex;              // Init string index / pending cell
+static unsigned char LCDCursor;             // Cell the LCD cursor is at
+
+/******************************************************************************/
+/* LCD Functions                                                              */
+/******************************************************************************/
+
+/*******************************
+ * LCDNibble(unsigned char nib)
+ *
+ * Clocks the upper nibble of nib into the LCD on RD7:RD4 with RS = LCDRS.
+ *******************************/
+static void LCDNibble(unsigned char nib)
+{
+    HalLCDNibble(LCDRS, nib);           // RS, E high, nibble, E low so LCD will accept it
+}
+
+/*******************************
+ * LCDSend(unsigned char byte, unsigned char rs, unsigned char next,
+ *         unsigned char hold)
+ *
+ * Sends the high nibble of byte now and schedules the low nibble for the next
+ * tick. Once the low nibble is out the driver waits hold ticks and enters next.
+ *******************************/
+static void LCDSend(unsigned char byte, unsigned char rs, unsigned char next, unsigned char hold)
+{
+    LCDByte = byte;
+    LCDRS = rs;
+    LCDNext = next;
+    LCDHold = hold;
+    LCDNibble(byte);                    // Send upper nibble
+    LCDState = LCDSendLow;
+    LCDWait = hold;
+}
+
+/*******************************
+ * LCDSendCell(unsigned char cell)
+ *
+ * Sends the frame buffer character at cell, assuming the cursor is already
+ * there. The HD44780 advances the cursor, except off the end of a row.
+ *******************************/
+static void LCDSendCell(unsigned char cell)
+{
+    char c = LCDFrame[cell];
+
+    LCDShown[cell] = c;
+    LCDCursor = ((cell & (LCDCols-1)) == LCDCols-1) ? LCDCursorLost : cell+1;
+    LCDSend(c, 1, LCDIdle, 0);
+}
+
+/*******************************
+ * LCDInit(const char * seq)
+ *
+ * Starts the LCD init sequence. seq is a zero terminated string of command
+ * bytes (e.g. 0x33,0x32,0x28,0x01,...) sent with RS low after the power up
+ * delay. Call before the Timer2 interrupt is enabled. The frame buffer is
+ * cleared to spaces to match the LCD after the clear command.
+ *******************************/
+void LCDInit(const char * seq)
+{
+    unsigned char i;
+
+    for (i = 0; i < LCDInitMax-1 && seq[i] != 0; i++)
+    {
+        LCDInitStr[i] = seq[i];
+    }
+    LCDInitStr[i] = 0;
+
+    for (i = 0; i < LCDCells; i++)
+    {
+        LCDFrame[i] = ' ';
+        LCDShown[i] = ' ';
+    }
+    LCDDirty = 0;
+    LCDIndex = 0;
+    LCDCursor = LCDCursorLost;
+    LCDWait = LCDPowerUpTicks;          // Wait 0.1 s to bypass LCD startup
+    LCDState = LCDPowerUp;
+}
+
+/*******************************
+ * LCDWrite(const char * str)
+ *
+ * Copies a message into the frame buffer and returns immediately. The first
+ * byte is a cursor-positioning code (0x80 line 1, 0xC0 line 2, plus column),
+ * optionally preceded by a 0x00 byte. The remaining bytes up to the zero
+ * terminator are placed from that position; text running off the display is
+ * dropped. Only cells that actually change are marked for the driver.
+ *******************************/
+void LCDWrite(const char * str)
+{
+    unsigned char code = *str++;
+    unsigned char cell;
+
+    if (code == 0)                      // Two-byte cursor code 0x00hh
+    {
+        code = *str++;
+    }
+    cell = ((code & 0x40) ? LCDCols : 0) + (code & (LCDCols-1));
+
+    while (*str != 0 && cell < LCDCells)
+    {
+        if (LCDFrame[cell] != *str)
+        {
+            LCDFrame[cell] = *str;
+            LCDDirty = 1;
+        }
+        cell++;
+        str++;
+    }
+}
+
+/*******************************
+ * LCDBusy(void)
+ *
+ * Returns nonzero while the LCD is initializing or has cells left to send.
+ *******************************/
+unsigned char LCDBusy(void)
+{
+    return (LCDState != LCDIdle) || LCDDirty;
+}
+
+/*******************************
+ * LCDService(void)
+ *
+ * Called by the low priority ISR on every Timer2 tick (1 ms). Sends at most
+ * one nibble per call, so a character costs two ticks, plus two more when the
+ * cursor has to be moved first. When idle the driver compares the frame buffer
+ * against what is shown, starting at the cursor so runs of changed cells go
+ * out without re-addressing. LCDDirty is cleared before the scan, so a writer
+ * that changes a cell behind the scan simply triggers another pass.
+ *******************************/
+void LCDService(void)
+{
+    unsigned char i;
+    unsigned char cell;
+
+    if (LCDWait != 0)                   // Still holding after the last nibble
+    {
+        LCDWait--;
+        return;
+    }
+
+    switch (LCDState)
+    {
+        case LCDSendLow:
+            LCDNibble(LCDByte << 4);    // Write lower nibble
+            LCDState = LCDNext;
+            LCDWait = LCDHold;
+            break;
+
+        case LCDPowerUp:
+            LCDState = LCDInitSeq;
+            break;
+
+        case LCDInitSeq:
+            if (LCDInitStr[LCDIndex] == 0)
+            {
+                LCDCursor = 0;          // Clear/entry mode leave the cursor home
+                LCDState = LCDIdle;
+                LCDDirty = 1;
+            }
+            else
+            {
+                LCDSend(LCDInitStr[LCDIndex++], 0, LCDInitSeq, LCDInitTicks);
+            }
+            break;
+
+        case LCDChar:
+            LCDSendCell(LCDIndex);
+            break;
+
+        case LCDIdle:
+            if (LCDDirty == 0)
+            {
+                break;
+            }
+            LCDDirty = 0;
+            cell = (LCDCursor == LCDCursorLost) ? 0 : LCDCursor;
+            for (i = 0; i < LCDCells; i++)
+            {
+                if (LCDFrame[cell] != LCDShown[cell])
+                {
+                    LCDDirty = 1;       // More cells may follow
+                    if (cell == LCDCursor)
+                    {
+                        LCDSendCell(cell);
+                    }
+                    else
+                    {
+                        LCDIndex = cell;    // Position cursor first
+                        LCDSend(0x80 | ((cell & LCDCols) ? 0x40 : 0) | (cell & (LCDCols-1)), 0, LCDChar, 0);
+                    }
+                    break;
+                }
+                cell = (cell+1) & (LCDCells-1);
+            }
+            break;
+
+        default:
+            LCDState = LCDIdle;
+            break;
+    }
+}
@@ -0,0 +1,32 @@
+/* 
+ * File:   lcd.h
+ *
+ * Non-blocking HD44780 driver. The application writes into a 2x16 shadow frame
+ * buffer and LCDService, called from the 1 ms Timer2 tick, sends one nibble per
+ * tick for the cells that differ from what the LCD is showing.
+ */
+
+#ifndef LCD_H
+#define	LCD_H
+
+#define LCDRows 2               // Display rows
+#define LCDCols 16              // Display columns
+#define LCDCells (LCDRows*LCDCols)
+#define LCDPowerUpTicks 100     // Ticks to wait after power up before init (100 ms)
+#define LCDInitTicks 10         // Ticks to hold after each init nibble (10 ms)
+#define LCDInitMax 8            // Longest init string (including terminating 0)
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void LCDInit(const char * seq);
+
+void LCDWrite(const char * str);
+
+void LCDService(void);
+
+unsigned char LCDBusy(void);
+
+
+#endif	/* LCD_H */
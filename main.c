@@ -16,7 +16,23 @@
 #include <math.h>
 #include "system.h"
 #include "user.h"
+#include "hal.h"
 #include "globals.h"        // Holds global variables
+#include "lcd.h"
+#include "control.h"
+#include "motion.h"
+#include "speed.h"
+#include "observer.h"
+#include "profile.h"
+#include "telemetry.h"
+#include "command.h"
+#include "protect.h"
+#include "encoder.h"
+#include "capture.h"
+#include "calib.h"
+#include "sched.h"
+#include "snapshot.h"
+#include "eelog.h"
 #include "timers.h"
 #include "pwm.h"
 #include "config.h"
@@ -26,23 +42,25 @@
 *******************************************************************************/
 
 #define USE_OR_MASKS        // For using peripheral library
-#define EncoderCount  0x0BDC// Load value to count 62500 times to TMR0 overflow (25ms)
-#define EncoderTS 1.0      // Total sample time for RPS calculation (s). EncoderTS = EncoderCount*EncoderTScount
-#define EncoderTScount 20   // Number of times to overflow TMR0 until EncoderTS is timed
 
-int CHA;                    // Preserve state of Channel A from encoder
-int CHB;                    // Preserve state of Channel B from encoder
-int OLD_ROT;                // Preserve state of current rotation in case encoder bounces
-int CCWTurn;                // Counts how many CCW turns have occured on the encoder
-int CWTurn;                 // Counts how many CW turns have occured on the encoder
-const int CountPerRev = 500;// Total counts per revolution (based on encoder specs)
-const int EncoderPoll = 128; // Total number of counts until direction of encoder rotation is determined
-double PartialRot;          // Holds fraction of revolution that has occured
-double RPS;                 // Holds rev/s value
-const int QEM[16] = {0,-1,1,2,1,0,2,-1,-1,2,0,1,2,1,-1,0};
-int CHAcount;
-
-int TMR0count;              // Counts how many timers TMR0 overflows to reach EncoderTS
+unsigned char EncoderState; // Preserve old (bits 7:4) and new (bits 3:0) encoder pins, A,B per axis from bit 1:0 up
+long EncoderPos[AxisCount];         // Signed encoder position in quadrature counts
+long EncoderLastPos[AxisCount];     // Encoder position at the last sample tick
+unsigned int EncoderErrors[AxisCount]; // Counts illegal quadrature transitions (both channels changed)
+unsigned int EncoderMissed[AxisCount]; // Edges known to be missed (illegal or empty RB-change interrupts)
+volatile unsigned char EdgeUp[AxisCount];      // CW edges latched by high_isr, free running
+volatile unsigned char EdgeDown[AxisCount];    // CCW edges latched by high_isr, free running
+volatile unsigned char EdgeIllegal[AxisCount]; // Illegal transitions seen by high_isr, free running
+volatile unsigned char EdgeNone;    // RB-change interrupts with no channel change, free running
+unsigned char EdgeDiff;             // high_isr scratch: channels that changed
+unsigned char EncFilt;              // EncoderSampled: filtered pins, as HalEncoderPins
+unsigned char EncCnt0;              // ... samples in a row each pin has differed from EncFilt,
+unsigned char EncCnt1;              // ... bit 0, 1 and 2 of a counter per pin (vertical counters)
+unsigned char EncCnt2;
+unsigned int PulseLast;     // Timer1 count at the last sample tick (SpeedTimer1 mode)
+const int CountPerRev = EncoderCPR;// Total counts per revolution (based on encoder specs)
+long RPS[AxisCount];        // Holds rev/s value in fixed point (milli-rev/s)
+long CHAcount[AxisCount];   // Encoder counts over the sliding sample window
 
 
 /*******************************************************************************
@@ -56,7 +74,7 @@ int main(void) {
     char LCDinit[] = {0x33,0x32,0x28,0x01,0x0c,0x06,0x00}; //Array holding initialization string for LCD
     char Msg1[] = {0x84,'C','U','N','T','\0'};
     char Msg2[] = {0xC5,'R','P','S','\0'};
-    char Msg3[10];          // Msg for displaying RPS to LCD (size 10 in case dealing with large numbers)
+    unsigned char a;
     InitApp();              // Initialize Ports
     DisplayLCD(LCDinit,1);  // Initialize LCD
 
@@ -67,40 +85,78 @@ int main(void) {
 
     //--------------
     // Initialize encoder variables
-    CHA = PORTBbits.RB5;    // Initialize channel A
-    CHB = PORTBbits.RB4;    // Initialize channel B
-    OLD_ROT = 0;            // Initialize state of rotation
-    CCWTurn = 0;            // Initialize CCW count
-    CWTurn = 0;             // Initialize CW count
-    RPS = 0.0;              // Initialize RPS value
-    CHAcount = 0;           // Channel A counter
+    EncoderState = HalEncoderPins(); // Initialize channels A, B of every axis (RB7:RB4)
+    EncFilt = EncoderState;     // Glitch filter settled on the present pins
+    EncCnt0 = 0;
+    EncCnt1 = 0;
+    EncCnt2 = 0;
+    for (a = 0; a < AxisCount; a++)
+    {
+        EncoderPos[a] = 0;      // Initialize position
+        EncoderLastPos[a] = 0;  // ...
+        EncoderErrors[a] = 0;   // Initialize illegal transition count
+        EncoderMissed[a] = 0;   // Initialize missed edge count
+        RPS[a] = 0;             // Initialize RPS value
+        CHAcount[a] = 0;        // Window counter
+        ObsInit(a, 0);          // Observer at rest
+    }
+    PulseLast = 0;          // Initialize Timer1 pulse count
+    SpeedMTInit();          // Initialize M/T estimator
+    SpeedWindowInit();      // Empty the sliding windows
 
     //--------------
     // Setup PWM cycle to motor
     PR2 = 0x9B;             // Open pwm1 at period = 1 ms
-    CCP1CONbits.DC1B1 = 0;  // Set duty cycle of pwm1
-    CCP1CONbits.DC1B0 = 0;  // ...
-    CCPR1L = 0b00000100;    // ...
+    ControlInit();          // Set duty cycle of every pwm, close the speed loops
+    MoveInit();             // Default acceleration limit and shape
+    for (a = 0; a < AxisCount; a++)
+    {
+        MoveTo(a, SetRPSInit);  // Ramp up to the start up speed
+    }
+    TlmInit();              // USART telemetry stream
+    CmdInit();              // USART commands
+    LogInit();              // EEPROM speed history, dump it once
+    ProtInit();             // No fault, PWM pins low when cut
+    CalInit();              // Feedforward table from the EEPROM, if there is one
+    CapInit();              // Edge capture off, Timer3 free running for its times
 
     //-------------
     // Set timer and interrupts
-    TMR0count = 0;          // Set counter for TMR0
-    WriteTimer0(EncoderCount);// Load Timer0
+#if SpeedTickTimer0
+    WriteTimer0(SpeedT0Reload);// Load Timer0 for the first sample tick
+#endif
+#if ISRProfile
+    ProfInit();             // Free running Timer3 for ISR timing
+#endif
+    SchedInit();            // Main loop tasks, most urgent first
+    if (SchedAdd(TlmSample, TlmDecim, 0) == SchedMaxTasks ||        // Telemetry frame every 10 ms
+        SchedAdd(CmdTask, CmdTaskMs, 0) == SchedMaxTasks ||         // Parse received commands
+        SchedAdd(CapTask, CapTaskMs, 5) == SchedMaxTasks ||         // Edge capture dump
+        SchedAdd(LogTask, LogTaskMs, 2) == SchedMaxTasks ||         // EEPROM log sums and dump
+        SchedAdd(CalTask, CalTaskMs, 3) == SchedMaxTasks ||         // Feedforward calibration sweep
+        SchedAdd(DisplayTask, DisplayPeriod, 1) == SchedMaxTasks)   // RPS on LCD, LEDs every 500 ms
+    {
+        HalPWMOff();        // Task table too small (SchedMaxTasks): stop here, D4 to D6 lit
+        HalLEDCW(1);
+        HalLEDCCW(1);
+        PORTAbits.RA1 = 1;
+        while (1)
+        {
+        }
+    }
     InitInterrupts();       // Initialize timer interrupts for Port B encoder
     
 
     //--------------
-    // Loop phase: Display RPS on LCD
-    while(1)
-    {
-        WaitHalfSec();
-        WriteLCD(0xC0,5,RPS,Msg3);      // Display RPS on LCD
-    }
+    // Loop phase: run the tasks, idle between ticks
+    SchedRun();
 
 
     //--------------
     // Exit main
+#if SpeedTickTimer0
     CloseTimer0();
+#endif
     return (EXIT_SUCCESS);
 }
 
@@ -108,16 +164,79 @@ int main(void) {
 ** Interrupt Service Routines
 *******************************************************************************/
 
+// Priority map (RCONbits.IPEN = 1):
+//   high  RB change      encoder edge latch (SpeedEdgeISR), both axes from one
+//                        PORTB read, 8 bit operations only; while armed, the
+//                        pins and Timer3 into the edge capture ring
+//   high  Timer0         instead with EncoderSampled: pins sampled through the
+//                        glitch filter, then the same edge latch. Either one
+//                        counts down the protection budgets and cuts the PWM
+//                        when one runs out (protect.h)
+//   low   CCP2 capture   encoder edge timestamp (SpeedMT)
+//   low   CCP2 compare   25 ms sample tick, special event resets Timer1/Timer3
+//                        (Timer0 overflow in SpeedMT or with two axes):
+//                        staged command, sliding window (RPS unless
+//                        observer/MT)
+//   low   Timer2         1 ms tick: fold latched edges; protection budgets and
+//                        stall check; per axis speed observer,
+//                        setpoint profile, speed loop; LCD, scheduler, speed
+//                        snapshot
+//   low   USART RX       command byte into the receive ring
+//   low   USART TX       telemetry bytes
+//   low   EEPROM         next queued log byte when a write is done
+// The high priority ISR makes no calls and its math is byte wide, so an edge
+// waits at most for another edge; everything that needs multi-byte math runs
+// at low priority. It still costs more than the fast return: XC8 saves and
+// restores FSR0-2, PROD, TBLPTR, TABLAT and PCLATH/U around any ISR, 66
+// cycles with the latency (tools/isrcheck on the listing of an empty
+// high_isr). Body cycles on top of that, counted at XC8 free mode code:
+//   RB change, the edge of one axis                  49   (115 in all)
+//   sampled, no pin passes the filter                49   (115)
+//   ... a pin that passes, decoded                  +14
+//   a second axis                                   +11, +25 with an edge
+//   capture armed (CapRecord, three rings, Timer3)  +82
+//   the edge that empties a budget (ProtTrip)       +10, +12 with two axes
+//   ... and masks RB change (HalEdgeIntOff)         +1
+// Longest paths: 208 cycles RB change (247 with two axes), 139 sampled (178).
+// At 115 cycles an edge high_isr alone takes 92% of the CPU at 10 rev/s on one
+// axis, and as much at 4.5 rev/s on each of two. Past that the edges used to
+// hold the CPU for good: in make -C sim sweep the low ISR ran once or twice
+// in 4 s from 12 rev/s up, and the counts, the loop and the commands stopped.
+// Every RB change interrupt now takes one off the edge budget, and the one
+// that empties it masks RB change until ProtTick refills it (encoder.h): the
+// low ISR gets at least 850 calls a second at any speed (10% of the CPU, the
+// ticks merged in pairs). The counts stay exact up to ProtMaxRPS (8 rev/s),
+// where the fault trips; past it the masked edges are lost, which before
+// held to 10 rev/s. The post build check
+// (Makefile HIGH_ISR_CYCLES) and the simulator (sim/sim.c SimCost) hold to
+// these counts.
+
 //------------------
 // High Priority Interrupts
 void high_priority interrupt high_isr(void)
 {
+    ProfEnter(ProfInHigh);      // Timestamp entry (ISRProfile builds)
 
-
-      /* TODO Add High Priority interrupt routine code here. */
-
-      /* Determine which flag generated the interrupt */
-      
+#if SpeedMode == SpeedEdgeISR
+#if EncoderSampled
+    if (INTCONbits.TMR0IF == 1)
+      {
+        EncFilter(HalEncoderPins()); // Glitch filter, then the filtered levels into EncoderState
+#else
+    if(INTCONbits.RBIF == 1)
+      {
+        EncLatch(HalEncoderPins()); // Read PORTB once, ends the mismatch
+        CapRecord();            // Raw edge capture, while armed
+#endif
+        EncDecode();            // Count the transition of every axis (encoder.h)
+#if EncoderSampled
+        INTCONbits.TMR0IF = 0;  // Clear Interrupt Flag
+#else
+        INTCONbits.RBIF = 0;    // Clear Interrupt Flag
+#endif
+        ProfLeave(ProfHigh, ProfInHigh);
+      }
+#endif
 
 }
 
@@ -125,37 +244,101 @@ void high_priority interrupt high_isr(void)
 // Low Priority Interrupts
 void low_priority interrupt low_isr(void)
 {
-    if(INTCONbits.RBIF == 1)
+    unsigned char a;
+    unsigned char n;
+
+    ProfEnter(ProfInLow);       // Timestamp entry (ISRProfile builds)
+
+#if SpeedMode == SpeedMT
+    if(PIR2bits.CCP2IF == 1)
       {
-        //ReadEncoder();          // Sample encoder
-        if (CHA == PORTBbits.RB5)
-        {
+        ReadCapture();          // Timestamp channel A edge
+        PIR2bits.CCP2IF = 0;    // Clear Interrupt Flag
+        ProfLeave(ProfEdge, ProfInLow);
+      }
 
+    else
+#endif
+#if SpeedTickTimer0
+    if (INTCONbits.TMR0IF == 1)
+#else
+    if (PIR2bits.CCP2IF == 1)
+#endif
+      {
+        ProfLatency();          // Tick timer is the cycles since the tick
+        if (CmdPending != 0)
+        {
+            CmdApply();         // Parameters change between ticks only
         }
-        else
+#if SpeedMode == SpeedEdgeISR
+        ReadEncoder();          // Fold edges latched by high_isr into EncoderPos
+#elif SpeedMode == SpeedTimer1
+        ReadPulseCount();       // Fold Timer1 pulse count into position
+#endif
+#if SpeedMode == SpeedMT
+        SpeedWindowUpdate(0);   // Window count only
+        RPS[0] = SpeedMTUpdate(); // M/T speed every tick
+#else
+        for (a = 0; a < AxisCount; a++)
         {
-            CHAcount++;         // Count Channel A pulses
+#if SpeedObserver
+            SpeedWindowUpdate(a);   // Window count only, RPS comes from the observer
+#else
+            RPS[a] = SpeedWindowUpdate(a); // Sliding window speed every tick
+#endif
         }
-        INTCONbits.RBIF = 0;    // Clear Interrupt Flag
+#endif
+#if SpeedTickTimer0
+        WriteTimer0(ReadTimer0() + SpeedT0Reload); // Add, so the latency is not lost
+        INTCONbits.TMR0IF = 0;      // Clear Interrupt Flag
+#else
+        PIR2bits.CCP2IF = 0;        // Clear Interrupt Flag (the timer reset itself)
+#endif
+        ProfLeave(ProfTMR0, ProfInLow);
       }
 
-    else if (INTCONbits.TMR0IF == 1)
+    else if (PIR1bits.TMR2IF == 1)
       {
-        if (TMR0count == EncoderTScount)
-        {
-            //RPS = (fabs(PartialRot))/EncoderTS;    // Compute rps by #rotations/sampletime = rev/sec
-            //PartialRot = 0.0;       // Clear revolution value
-            RPS = ((double)CHAcount)/CountPerRev; // In 0.5 seconds counting half of 500 pulses
-            CHAcount = 0;
-
-            TMR0count = 0;          // Clear TMR0 counter
-        }
-        else
+#if SpeedMode == SpeedEdgeISR
+        ReadEncoder();              // Fold edges latched by high_isr into EncoderPos
+#elif SpeedMode == SpeedTimer1 && SpeedObserver
+        ReadPulseCount();           // The observer needs the position every tick
+#endif
+#if SpeedMode != SpeedMT
+        n = SpeedT2Periods();       // Ticks merged under high_isr load count for the budgets and observer
+#else
+        n = 1;
+#endif
+        ProtTick(n);                // Refill the high_isr budgets, look for a stall
+        for (a = 0; a < AxisCount; a++)
         {
-            TMR0count++;            // Increment TMR0 counter
+#if SpeedMode != SpeedMT && SpeedObserver
+            RPS[a] = ObsUpdate(a, EncoderPos[a], n); // Alpha-beta speed estimate every tick
+#endif
+            MoveTick(a);            // Next acceleration limited setpoint
+            ControlTick(a);         // Run the PI speed loop (1 kHz)
         }
-        WriteTimer0(EncoderCount);  // Reload timer0
-        INTCONbits.TMR0IF = 0;      // Clear Interrupt Flag
+        LCDService();               // Send at most one nibble to the LCD
+        SchedTicks++;               // Release main loop tasks
+        SnapPublish();              // Consistent speed state for the main loop
+        PIR1bits.TMR2IF = 0;        // Clear Interrupt Flag
+        ProfLeave(ProfTMR2, ProfInLow);
+      }
+
+    else if (PIR1bits.RCIF == 1)
+      {
+        CmdRx();                    // Received byte into the ring (RCIF clears on the RCREG read)
+      }
+
+    else if (PIR1bits.TXIF == 1 && PIE1bits.TXIE == 1)
+      {
+        TlmTx();                    // Next telemetry byte (TXIF clears on the TXREG write)
+      }
+
+    else if (PIR2bits.EEIF == 1)
+      {
+        PIR2bits.EEIF = 0;          // Clear Interrupt Flag
+        LogWrite();                 // Next queued EEPROM byte
       }
 
 }
\ No newline at end of file
@@ -0,0 +1,214 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "globals.h"
+#include "control.h"
+#include "motion.h"
+
+/******************************************************************************/
+/* Motion Profile Variables                                                   */
+/******************************************************************************/
+
+unsigned int MoveAccel;         // Acceleration limit for the next MoveTo (milli-rev/s per tick)
+unsigned char MoveShape;        // Shape for the next MoveTo (MoveLinear, MoveSCurve)
+unsigned char MoveActive[AxisCount]; // 1 while MoveTick owns SetRPS
+
+static long MoveFrom[AxisCount];    // Setpoint at the start of the move (milli-rev/s)
+static long MoveDelta[AxisCount];   // Speed change of the move (milli-rev/s)
+static unsigned long MovePhase[AxisCount]; // Progress through the move, Q16 (0x10000 = done)
+static unsigned long MoveStep[AxisCount];  // MovePhase increment per tick
+static unsigned char MoveCurve[AxisCount]; // Shape of the move in progress
+
+// 32768*(3x^2-2x^3) at x = i/64
+static const unsigned int MoveSCurveTable[(1 << MoveTableLog2) + 1] =
+{
+        0,    24,    94,   209,   368,   569,   810,  1090,
+     1408,  1762,  2150,  2571,  3024,  3507,  4018,  4556,
+     5120,  5708,  6318,  6949,  7600,  8269,  8954,  9654,
+    10368, 11094, 11830, 12575, 13328, 14087, 14850, 15616,
+    16384, 17152, 17918, 18681, 19440, 20193, 20938, 21674,
+    22400, 23114, 23814, 24499, 25168, 25819, 26450, 27060,
+    27648, 28212, 28750, 29261, 29744, 30197, 30618, 31006,
+    31360, 31678, 31958, 32199, 32400, 32559, 32674, 32744,
+    32768
+};
+
+/******************************************************************************/
+/* Motion Profile Functions                                                   */
+/******************************************************************************/
+
+/*******************************
+ * MoveInit(void)
+ *
+ * Loads the default acceleration and shape with no move in progress on any
+ * axis.
+ *******************************/
+void MoveInit(void)
+{
+    unsigned char a;
+
+    MoveAccel = MoveAccelInit;
+    MoveShape = MoveShapeInit;
+    for (a = 0; a < AxisCount; a++)
+    {
+        MoveActive[a] = 0;
+    }
+}
+
+/*******************************
+ * MovePlan(unsigned char a, long rps, long * delta)
+ *
+ * Works out a move of the SetRPS of axis a to rps (milli-rev/s) with the
+ * present MoveAccel and MoveShape, from the setpoint in effect now, and
+ * returns its phase step per tick (1 or more), the change in *delta. A move
+ * in progress is ended first, so the setpoint holds where it is until
+ * MoveStart loads the new one and the move starts without a step. A change
+ * of more than MoveDeltaMax is refused: it returns 0 and leaves the move in
+ * progress and *delta as they were. The one division is done
+ * here, in the caller's context: the move lasts |delta|/MoveAccel ticks (1.5
+ * times that for the S-curve, whose peak acceleration is 1.5 times its
+ * mean), and MoveTick only adds the per tick phase step. Main loop only.
+ *******************************/
+unsigned long MovePlan(unsigned char a, long rps, long * delta)
+{
+    long from;
+    long d;
+    unsigned long step;
+    unsigned long mag;
+
+    PIE1bits.TMR2IE = 0;                // Hold off MoveTick and ControlTick
+    from = SetRPS[a];
+    d = rps - from;
+    if (d > MoveDeltaMax || d < -MoveDeltaMax)
+    {
+        PIE1bits.TMR2IE = 1;
+        return 0;                       // Too far: the move in progress goes on
+    }
+    MoveActive[a] = 0;                  // Preempt: hold the setpoint reached so far
+    PIE1bits.TMR2IE = 1;
+
+    mag = (d < 0) ? (unsigned long)-d : (unsigned long)d;
+
+    step = 0x10000UL;                   // No limit or no change: one tick
+    if (mag != 0 && MoveAccel != 0)
+    {
+        step = ((unsigned long)MoveAccel << 16) / mag;
+        if (step > 0x10000UL)
+        {
+            step = 0x10000UL;
+        }
+        if (MoveShape == MoveSCurve)
+        {
+            step = (step * 2) / 3;
+        }
+        if (step == 0)
+        {
+            step = 1;                   // At most 65536 ticks
+        }
+    }
+    *delta = d;
+    return step;
+}
+
+/*******************************
+ * MoveStart(unsigned char a, long delta, unsigned long step)
+ *
+ * Loads a move planned by MovePlan on axis a, from the setpoint it held.
+ * No divisions or loops, so the low priority ISR may call it; other callers
+ * mask the Timer2 interrupt around it so MoveTick never sees half a move.
+ *******************************/
+void MoveStart(unsigned char a, long delta, unsigned long step)
+{
+    MoveFrom[a] = SetRPS[a];
+    MoveDelta[a] = delta;
+    MovePhase[a] = 0;
+    MoveStep[a] = step;
+    MoveCurve[a] = MoveShape;
+    MoveActive[a] = 1;
+}
+
+/*******************************
+ * MoveTo(unsigned char a, long rps)
+ *
+ * Starts a move of the SetRPS of axis a to rps (milli-rev/s) now (see
+ * MovePlan), and returns 0 if it was refused as more than MoveDeltaMax
+ * away. The Timer2 interrupt is masked only while the setpoint is read and
+ * while the move is loaded.
+ *******************************/
+unsigned char MoveTo(unsigned char a, long rps)
+{
+    long delta;
+    unsigned long step;
+
+    step = MovePlan(a, rps, &delta);
+    if (step == 0)
+    {
+        return 0;
+    }
+    PIE1bits.TMR2IE = 0;
+    MoveStart(a, delta, step);
+    PIE1bits.TMR2IE = 1;
+    return 1;
+}
+
+/*******************************
+ * MoveStop(unsigned char a)
+ *
+ * Ends a move in progress on axis a, holding the setpoint it had reached.
+ *******************************/
+void MoveStop(unsigned char a)
+{
+    PIE1bits.TMR2IE = 0;
+    MoveActive[a] = 0;
+    PIE1bits.TMR2IE = 1;
+}
+
+/*******************************
+ * MoveTick(unsigned char a)
+ *
+ * Called by the low priority ISR on every Timer2 tick for each axis a before
+ * its ControlTick.
+ * Advances the phase and sets SetRPS = from + delta*shape(phase), shape in
+ * Q15. The S-curve is a table lookup with linear interpolation between the
+ * two neighbouring entries, so the cost per tick is one add, a table read
+ * pair and two multiplies whatever the move, with no loops or divisions.
+ *******************************/
+void MoveTick(unsigned char a)
+{
+    unsigned long phase;
+    unsigned int idx;
+    unsigned int frac;
+    unsigned int lo;
+    long s;
+
+    if (MoveActive[a] == 0)
+    {
+        return;
+    }
+
+    phase = MovePhase[a] + MoveStep[a];
+    MovePhase[a] = phase;
+    if (phase >= 0x10000UL)             // Done: land exactly on the target
+    {
+        SetRPS[a] = MoveFrom[a] + MoveDelta[a];
+        MoveActive[a] = 0;
+        return;
+    }
+
+    if (MoveCurve[a] == MoveSCurve)
+    {
+        idx = (unsigned int)(phase >> (16 - MoveTableLog2));
+        frac = (unsigned int)phase & ((1 << (16 - MoveTableLog2)) - 1);
+        lo = MoveSCurveTable[idx];
+        s = lo + (((long)(MoveSCurveTable[idx+1] - lo) * frac) >> (16 - MoveTableLog2));
+    }
+    else
+    {
+        s = (long)(phase >> 1);
+    }
+    SetRPS[a] = MoveFrom[a] + ((MoveDelta[a] * s) >> 15);
+}
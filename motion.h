@@ -0,0 +1,43 @@
+/*
+ * File:   motion.h
+ *
+ * Acceleration limited speed setpoints, one move per axis. MoveTo starts a
+ * move from the present setpoint to a new speed; MoveTick then steps SetRPS
+ * along a linear (trapezoidal move) or cubic S-curve shape on every Timer2
+ * tick, just before ControlTick. A new MoveTo preempts a move in progress from wherever it is.
+ */
+
+#ifndef MOTION_H
+#define	MOTION_H
+
+// Move shapes
+#define MoveLinear 0            // Constant acceleration (trapezoidal speed profile)
+#define MoveSCurve 1            // Cubic 3x^2-2x^3, peak acceleration 1.5x the mean
+
+#define MoveTableLog2 6         // S-curve table of 2^6 steps
+#define MoveAccelInit 5         // Acceleration limit, milli-rev/s per tick (about rev/s^2)
+#define MoveShapeInit MoveSCurve
+#define MoveDeltaMax 65535L     // Largest speed change in one move (milli-rev/s), more is refused
+
+extern unsigned int MoveAccel;
+extern unsigned char MoveShape;
+extern unsigned char MoveActive[AxisCount];
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void MoveInit(void);
+
+unsigned long MovePlan(unsigned char a, long rps, long * delta);
+
+void MoveStart(unsigned char a, long delta, unsigned long step);
+
+unsigned char MoveTo(unsigned char a, long rps);
+
+void MoveStop(unsigned char a);
+
+void MoveTick(unsigned char a);
+
+
+#endif	/* MOTION_H */
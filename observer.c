@@ -0,0 +1,117 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include "system.h"
+#include "globals.h"
+#include "observer.h"
+
+/******************************************************************************/
+/* Observer Variables                                                         */
+/******************************************************************************/
+
+long ObsVel[AxisCount];             // Velocity estimate, counts per tick Q16
+#if ObsGammaShift
+long ObsAcc[AxisCount];             // Acceleration estimate, counts per tick^2 Q24
+#endif
+
+static unsigned long ObsPos[AxisCount]; // Position estimate, counts Q8, wraps with EncoderPos
+
+/******************************************************************************/
+/* Observer Functions                                                         */
+/******************************************************************************/
+
+/*******************************
+ * ObsInit(unsigned char a, long pos)
+ *
+ * Starts the observer of axis a at rest at position pos (counts).
+ *******************************/
+void ObsInit(unsigned char a, long pos)
+{
+    ObsPos[a] = (unsigned long)pos << 8;
+    ObsVel[a] = 0;
+#if ObsGammaShift
+    ObsAcc[a] = 0;
+#endif
+}
+
+/*******************************
+ * ObsUpdate(unsigned char a, long pos, unsigned char n)
+ *
+ * Called by the low priority ISR on every Timer2 tick with the current
+ * EncoderPos of axis a and the n Timer2 periods since the last call
+ * (SpeedT2Periods, 1 unless ticks were merged), and returns its velocity
+ * estimate in milli-rev/s. The position is predicted n ticks ahead from the
+ * velocity, and the residual against the measured count corrects the position
+ * by alpha and the velocity by beta:
+ *
+ *     x += v;  r = pos - x;  x += r*alpha;  v += r*beta
+ *
+ * With ObsGammaShift the prediction also uses the acceleration a, which is
+ * corrected by 2*gamma*r, so a ramp is tracked without lag at the cost of
+ * more overshoot after a step.
+ *
+ * The ticks merged into one call had no measurement, so they are predicted
+ * only, and the correction is that of a single tick. Predicting one tick per
+ * call instead would read the counts of n ticks as the speed of one.
+ *
+ * Between counts the residual is the sub-count error of the prediction, so
+ * the velocity settles to a fraction of a count per tick instead of jumping
+ * between whole counts per window, and a speed change shows within a few
+ * ticks. The position is held in Q8 as an unsigned long and the residual is
+ * formed by a wrapping subtract, so it works across EncoderPos wrap. The
+ * residual is clamped so a jump (first tick, lost counts) cannot overflow
+ * the velocity update. The gain to milli-rev/s is taken from the exact
+ * Timer2 period and split into whole and sixteenths so no product overflows.
+ * The state of the axis is worked on in locals, so it is indexed only once.
+ *******************************/
+long ObsUpdate(unsigned char a, long pos, unsigned char n)
+{
+    unsigned long x = ObsPos[a];
+    long v = ObsVel[a];
+#if ObsGammaShift
+    long acc = ObsAcc[a];
+#endif
+    long res;
+    long w;
+
+    do
+    {
+#if ObsGammaShift
+        x += (v + (acc >> 9) + 128) >> 8;           // Predict, x += v + a/2
+        v += acc >> 8;
+#else
+        x += (v + 128) >> 8;                        // Predict, rounded
+#endif
+    } while (--n != 0);
+    res = (long)(((unsigned long)pos << 8) - x);    // Residual, Q8 counts
+    if (res > ObsResMax)
+    {
+        res = ObsResMax;
+    }
+    else if (res < -ObsResMax)
+    {
+        res = -ObsResMax;
+    }
+    x += (res + (1 << (ObsAlphaShift-1))) >> ObsAlphaShift; // Correct, rounded
+    v += (res << 8) >> ObsBetaShift;
+#if ObsGammaShift
+    acc += (res << 8) >> (ObsGammaShift-9);         // 2*gamma*r in Q24
+    ObsAcc[a] = acc;
+#endif
+    ObsPos[a] = x;
+    ObsVel[a] = v;
+
+    w = v >> 4;                                     // Q12, so the products fit to 524 rev/s
+    return (w * (ObsRPSGainQ4 >> 4) + ((w * (ObsRPSGainQ4 & 15)) >> 4) + 2048) >> 12;
+}
+
+/*******************************
+ * ObsPosition(unsigned char a)
+ *
+ * Position estimate of axis a in whole counts.
+ *******************************/
+long ObsPosition(unsigned char a)
+{
+    return (long)(ObsPos[a] >> 8);
+}
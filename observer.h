@@ -0,0 +1,51 @@
+/*
+ * File:   observer.h
+ *
+ * Integer alpha-beta observer of encoder position and velocity, optionally
+ * acceleration, one per axis, run on every Timer2 tick (1 ms nominal). The
+ * gains are powers of two so the update is shifts and adds. No SFR
+ * dependencies, so it also builds on the host (tools/obsbench.c).
+ */
+
+#ifndef OBSERVER_H
+#define	OBSERVER_H
+
+// Use the observer for RPS (SpeedEdgeISR and SpeedTimer1). 0: sliding window
+#ifndef SpeedObserver
+#define SpeedObserver 1
+#endif
+
+// Gains are powers of two, 1/2^shift (tools/obsbench compares other choices)
+#ifndef ObsAlphaShift
+#define ObsAlphaShift 4         // alpha = 1/16: position correction per tick
+#endif
+#ifndef ObsBetaShift
+#define ObsBetaShift 9          // beta = 1/512, about alpha^2/(2-alpha) (steady state Kalman)
+#endif
+#ifndef ObsGammaShift
+#define ObsGammaShift 0         // gamma = 1/2^shift adds acceleration, 17 suits the above (0: off)
+#endif
+#if ObsAlphaShift < 1 || ObsBetaShift > 16 || (ObsGammaShift != 0 && ObsGammaShift < 9)
+#error "Observer gain shifts out of range"
+#endif
+#define ObsTickCycles 2496L     // Timer2 period (PR2+1)*16 with PR2 = 0x9B: 0.9984 ms
+#define ObsResMax (1L << 22)    // Residual clamp, Q8 counts (16384 counts)
+#define ObsRPSGainQ4 (((16L*(SYS_FREQ/4)/EncoderCPR)*RPSScale + ObsTickCycles/2)/ObsTickCycles) // Counts per tick to milli-rev/s, Q4
+
+extern long ObsVel[AxisCount];  // Velocity estimate, counts per tick Q16
+#if ObsGammaShift
+extern long ObsAcc[AxisCount];  // Acceleration estimate, counts per tick^2 Q24
+#endif
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void ObsInit(unsigned char a, long pos);
+
+long ObsUpdate(unsigned char a, long pos, unsigned char n);
+
+long ObsPosition(unsigned char a);
+
+
+#endif	/* OBSERVER_H */
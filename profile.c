@@ -0,0 +1,231 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "timers.h"
+#include "globals.h"
+#include "profile.h"
+#include "format.h"
+
+/******************************************************************************/
+/* Profiling Variables                                                        */
+/******************************************************************************/
+
+ProfStat ProfStats[ProfBranches];   // Per branch timing
+unsigned int ProfLatMax;            // Worst sample tick entry latency (cycles)
+unsigned int ProfLat[ProfBins];     // log2 histogram of sample tick entry latency
+unsigned int ProfInLow;             // Timer3 at low priority ISR entry
+unsigned int ProfInHigh;            // Timer3 at high priority ISR entry
+
+static const char ProfLabel[ProfBranches] = {'E','0','2','H'};
+
+/******************************************************************************/
+/* Profiling Functions                                                        */
+/******************************************************************************/
+
+/*******************************
+ * ProfBin(unsigned int v)
+ *
+ * Returns the number of significant bits in v, limited to the last bin.
+ *******************************/
+static unsigned char ProfBin(unsigned int v)
+{
+    unsigned char n = 0;
+
+    if (v & 0xFF00)
+    {
+        n = 8;
+        v >>= 8;
+    }
+    while (v != 0)
+    {
+        v >>= 1;
+        n++;
+    }
+    return (n < ProfBins) ? n : ProfBins-1;
+}
+
+/*******************************
+ * ProfCount(unsigned int * hist, unsigned int v)
+ *
+ * Counts v in a log2 histogram. A full bin halves the whole histogram so the
+ * shape is kept over long runs.
+ *******************************/
+static void ProfCount(unsigned int * hist, unsigned int v)
+{
+    unsigned char i;
+
+    if (++hist[ProfBin(v)] == 0xFFFF)
+    {
+        for (i = 0; i < ProfBins; i++)
+        {
+            hist[i] >>= 1;
+        }
+    }
+}
+
+/*******************************
+ * ProfReset(void)
+ *
+ * Clears all statistics. Interrupts are held off while clearing.
+ *******************************/
+void ProfReset(void)
+{
+    unsigned char b;
+    unsigned char i;
+    unsigned char gieh = INTCONbits.GIEH;
+
+    INTCONbits.GIEH = 0;
+    for (b = 0; b < ProfBranches; b++)
+    {
+        ProfStats[b].Calls = 0;
+        ProfStats[b].Sum = 0;
+        ProfStats[b].Min = 0xFFFF;
+        ProfStats[b].Max = 0;
+        ProfStats[b].GapMax = 0;
+        for (i = 0; i < ProfBins; i++)
+        {
+            ProfStats[b].Dur[i] = 0;
+            ProfStats[b].Gap[i] = 0;
+        }
+    }
+    ProfLatMax = 0;
+    for (i = 0; i < ProfBins; i++)
+    {
+        ProfLat[i] = 0;
+    }
+    INTCONbits.GIEH = gieh;
+}
+
+/*******************************
+ * ProfInit(void)
+ *
+ * Clears the statistics and starts Timer3 free running at 1:1 on the
+ * instruction clock. In SpeedMT Timer3 is already running at 1:8 for CCP2 and
+ * is left alone; durations are then counted in 8 cycle ticks. In SpeedTimer1
+ * Timer3 is the sample tick timebase and is reset every tick, so a duration
+ * or gap spanning a tick reads short. Call before InitInterrupts.
+ *******************************/
+void ProfInit(void)
+{
+    ProfReset();
+#if SpeedMode != SpeedMT
+    T3CONbits.RD16 = 1;                     // 16 bit reads
+    T3CONbits.T3CKPS1 = 0;                  // 1:1 prescaler
+    T3CONbits.T3CKPS0 = 0;                  // ...
+    T3CONbits.TMR3CS = 0;                   // Internal clock
+    T3CONbits.TMR3ON = 1;                   // Turn on Timer3
+#endif
+}
+
+/*******************************
+ * ProfRecord(unsigned char branch, unsigned int start)
+ *
+ * Called at the end of an ISR branch with the Timer3 value taken at ISR
+ * entry. Records the duration, including the context save and the cost of
+ * this call up to the timer read, and the gap since the previous entry into
+ * the same branch. Gaps longer than one Timer3 period wrap.
+ *******************************/
+void ProfRecord(unsigned char branch, unsigned int start)
+{
+    ProfStat * s = &ProfStats[branch];
+    unsigned int d = (uint16_t)(ReadTimer3() - start);   // Timer3 is 16 bits, also on the host
+    unsigned int g = (uint16_t)(start - s->Last);
+
+    s->Last = start;
+    if (s->Calls != 0)
+    {
+        if (g > s->GapMax)
+        {
+            s->GapMax = g;
+        }
+        ProfCount(s->Gap, g);
+    }
+    if (s->Calls == 0xFFFF)
+    {
+        s->Calls >>= 1;                     // Keep the mean, drop half the weight
+        s->Sum >>= 1;
+    }
+    s->Calls++;
+    s->Sum += d;
+    if (d < s->Min)
+    {
+        s->Min = d;
+    }
+    if (d > s->Max)
+    {
+        s->Max = d;
+    }
+    ProfCount(s->Dur, d);
+}
+
+/*******************************
+ * ProfRecordLatency(unsigned int now)
+ *
+ * Called first thing in the sample tick branch with the tick timer. It runs
+ * at 1:1 from 0 after the special event reset (Timer0 in SpeedMT: after the
+ * overflow), so it holds the cycles from the tick to the branch: context
+ * save plus any time the interrupt was held off by other ISRs or masked code.
+ *******************************/
+void ProfRecordLatency(unsigned int now)
+{
+    if (now > ProfLatMax)
+    {
+        ProfLatMax = now;
+    }
+    ProfCount(ProfLat, now);
+}
+
+/*******************************
+ * ProfReport(char * buf, unsigned char page)
+ *
+ * Formats one 16 character LCD line of the statistics into buf and returns
+ * its length. Pages 0..ProfBranches-1 show a branch as its label then the
+ * min, mean and max duration in instruction cycles, e.g. "0  212  230  598".
+ * Page ProfBranches shows the worst sample tick entry latency, "L max     41".
+ *******************************/
+int ProfReport(char * buf, unsigned char page)
+{
+    unsigned int calls;
+    unsigned long sum;
+    unsigned int min;
+    unsigned int max;
+    unsigned char gieh = INTCONbits.GIEH;
+
+    if (page >= ProfBranches)
+    {
+        INTCONbits.GIEH = 0;
+        max = ProfLatMax;
+        INTCONbits.GIEH = gieh;
+        buf[0] = 'L';
+        buf[1] = ' ';
+        buf[2] = 'm';
+        buf[3] = 'a';
+        buf[4] = 'x';
+        return 5 + FormatInt(buf+5, max, 11, '!');
+    }
+
+    INTCONbits.GIEH = 0;                    // Copy without tearing
+    calls = ProfStats[page].Calls;
+    sum = ProfStats[page].Sum;
+    min = ProfStats[page].Min;
+    max = ProfStats[page].Max;
+    INTCONbits.GIEH = gieh;
+
+    buf[0] = ProfLabel[page];
+    if (calls == 0)
+    {
+        min = 0;
+        sum = 0;
+    }
+    else
+    {
+        sum /= calls;
+    }
+    FormatInt(buf+1, (long)min << ProfShift, 5, '!');
+    FormatInt(buf+6, (long)sum << ProfShift, 5, '!');
+    return 11 + FormatInt(buf+11, (long)max << ProfShift, 5, '!');
+}
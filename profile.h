@@ -0,0 +1,78 @@
+/*
+ * File:   profile.h
+ *
+ * Optional ISR cycle budget instrumentation (build with -DISRProfile=1).
+ * Each ISR branch is timed from ISR entry to the end of the branch on Timer3,
+ * keeping min/max/mean and log2 histograms of the durations and of the gaps
+ * between calls. Sample tick entry latency is taken from the tick timer
+ * itself (see SpeedTickNow). With
+ * ISRProfile 0 the hooks compile to nothing.
+ */
+
+#ifndef PROFILE_H
+#define	PROFILE_H
+
+#ifndef ISRProfile
+#define ISRProfile 0
+#endif
+
+// Timed ISR branches
+#define ProfEdge 0              // RB change or CCP2 capture (encoder edges)
+#define ProfTMR0 1              // Sample tick
+#define ProfTMR2 2              // Timer2 control and LCD tick
+#define ProfHigh 3              // Any high priority branch
+#define ProfBranches 4
+
+#define ProfBins 16             // Bin n counts values of n significant bits (n = 15 also holds 16)
+
+// Timer3 is shared with CCP2 at 1:8 in SpeedMT, otherwise it runs at 1:1
+#if SpeedMode == SpeedMT
+#define ProfShift 3             // Timer3 tick = 8 instruction cycles
+#else
+#define ProfShift 0             // Timer3 tick = 1 instruction cycle (wraps in 26 ms)
+#endif
+
+typedef struct
+{
+    unsigned int Calls;         // Calls counted in Sum (halved with Sum near overflow)
+    unsigned long Sum;          // Sum of durations, Timer3 ticks
+    unsigned int Min;           // Shortest duration, Timer3 ticks
+    unsigned int Max;           // Longest duration, Timer3 ticks
+    unsigned int GapMax;        // Longest gap between entries, Timer3 ticks (wraps past 16 bits)
+    unsigned int Last;          // Timer3 at the last entry
+    unsigned int Dur[ProfBins]; // log2 histogram of durations
+    unsigned int Gap[ProfBins]; // log2 histogram of gaps between entries
+} ProfStat;
+
+extern ProfStat ProfStats[ProfBranches];
+extern unsigned int ProfLatMax;             // Worst sample tick entry latency (cycles)
+extern unsigned int ProfLat[ProfBins];      // log2 histogram of sample tick entry latency
+extern unsigned int ProfInLow;              // Timer3 at low priority ISR entry
+extern unsigned int ProfInHigh;             // Timer3 at high priority ISR entry
+
+#if ISRProfile
+#define ProfEnter(t)        (t) = ReadTimer3()
+#define ProfLeave(b, t)     ProfRecord((b), (t))
+#define ProfLatency()       ProfRecordLatency(SpeedTickNow())
+#else
+#define ProfEnter(t)
+#define ProfLeave(b, t)
+#define ProfLatency()
+#endif
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void ProfInit(void);
+
+void ProfReset(void);
+
+void ProfRecord(unsigned char branch, unsigned int start);
+
+void ProfRecordLatency(unsigned int now);
+
+int ProfReport(char * buf, unsigned char page);
+
+
+#endif	/* PROFILE_H */
@@ -0,0 +1,212 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "timers.h"
+#include "hal.h"
+#include "globals.h"
+#include "speed.h"
+#include "observer.h"
+#include "control.h"
+#include "motion.h"
+#include "protect.h"
+
+/******************************************************************************/
+/* Protection Variables                                                       */
+/******************************************************************************/
+
+volatile unsigned char ProtFault;   // Latched fault, ProtAxis(a) | code, 0 while none
+volatile unsigned char ProtEdges[AxisCount];   // Edges left this tick, high_isr counts down
+volatile unsigned char ProtIllegal[AxisCount]; // Illegal transitions left this window, ...
+
+static long ProtLastPos[AxisCount]; // EncoderPos when it last moved
+static unsigned char ProtIdle[AxisCount]; // Timer2 periods since then at ProtStallDuty or more
+static unsigned char ProtWindow;    // Ticks into the illegal transition window
+
+// SpeedTimer1: channel A rising edges counted by Timer1 on T13CKI, with no
+// interrupt to take them off the budget one by one
+#if SpeedMode == SpeedTimer1
+#define ProtCount()     ReadTimer1()
+static unsigned int ProtCountLast;  // ProtCount at the last tick
+static unsigned int ProtLeft;       // Edges left of the budget, as ProtEdges
+#endif
+
+// RB change: high_isr masks it on the edge that empties ProtEdges (encoder.h)
+#if SpeedMode == SpeedEdgeISR && !EncoderSampled
+#define ProtEdgesOn()   HalEdgeIntOn()
+#else
+#define ProtEdgesOn()
+#endif
+
+/******************************************************************************/
+/* Protection Functions                                                       */
+/******************************************************************************/
+
+/*******************************
+ * ProtRefill(void)
+ *
+ * Full budgets and no stall count on every axis, as at the start of a tick
+ * window.
+ *******************************/
+static void ProtRefill(void)
+{
+    unsigned char a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        ProtEdges[a] = ProtEdgesCap;
+        ProtIllegal[a] = ProtIllegalMax;
+        ProtLastPos[a] = EncoderPos[a];
+        ProtIdle[a] = 0;
+    }
+    ProtWindow = 0;
+#if SpeedMode == SpeedTimer1
+    ProtCountLast = ProtCount();
+    ProtLeft = ProtEdgesCap;
+#endif
+}
+
+/*******************************
+ * ProtInit(void)
+ *
+ * No fault, full budgets, and the PWM pins' port latches low so that they
+ * stay low when a fault turns the CCP modules off. Call after the encoder
+ * positions are set, before InitInterrupts.
+ *******************************/
+void ProtInit(void)
+{
+    PORTCbits.RC2 = 0;                  // CCP1 pin when the PWM is off
+#if AxisCount > 1
+    PORTCbits.RC1 = 0;                  // CCP2 pin, axis 1
+#endif
+    ProtFault = 0;
+    ProtRefill();
+#if SpeedMode == SpeedTimer1
+    ProtCountLast = PulseLast;          // InitInterrupts starts Timer1 from here
+#endif
+}
+
+/*******************************
+ * ProtTick(n)
+ *
+ * Called by the low priority ISR on every Timer2 tick (1 ms), after the
+ * positions and speeds are updated and before the loops run, with the Timer2
+ * periods n since the call before (more than 1 when high_isr held the tick
+ * back). With a fault latched it holds every loop open at zero duty and ends
+ * any move. Otherwise it refills the high_isr budgets, ProtEdges by
+ * ProtEdgesMs for each period and ProtIllegal in full every ProtWindowMs, and
+ * counts the periods each axis has had ProtStallDuty or more without its
+ * position changing; ProtStallMs of them trip a stall. RB change, masked by
+ * the edge that emptied ProtEdges, is back on after the refill, fault or
+ * not: the budget goes on pacing high_isr while a fault is latched. With SpeedMT the
+ * captures take the edges off ProtEdges (ReadCapture); with SpeedTimer1 the
+ * Timer1 count since the last tick (ProtCount) is taken off its budget here,
+ * all at once, and the tick that empties it trips. A trip from here masks
+ * high_isr for the few instructions of ProtTrip, so the first fault is the
+ * one kept.
+ *******************************/
+void ProtTick(unsigned char n)
+{
+    unsigned char a;
+    unsigned char code = 0;
+#if SpeedMode != SpeedTimer1
+    unsigned char r = ProtEdgesCap;
+#else
+    unsigned int r = ProtEdgesCap;
+    unsigned int c;
+#endif
+
+    if (ProtFault != 0)
+    {
+        for (a = 0; a < AxisCount; a++)
+        {
+            MoveActive[a] = 0;
+            SetRPS[a] = 0;
+            ControlHold(a, 0);
+            ProtEdges[a] = ProtEdgesCap;
+        }
+        ProtEdgesOn();
+        return;
+    }
+
+    if (++ProtWindow >= ProtWindowMs)
+    {
+        ProtWindow = 0;
+    }
+    if (n <= ProtEdgesCap / ProtEdgesMs)
+    {
+#if SpeedMode != SpeedTimer1
+        r = (unsigned char)(n * ProtEdgesMs); // Edges of the periods, at most ProtEdgesCap
+#else
+        r = (unsigned int)(n * ProtEdgesMs);
+#endif
+    }
+#if SpeedMode == SpeedTimer1
+    c = (unsigned int)(ProtCount() - ProtCountLast); // Edges since the last tick
+    ProtCountLast += c;
+    if (c >= ProtLeft)
+    {
+        code = ProtAxis(0) | ProtOverspeed; // One axis only
+    }
+    else
+    {
+        ProtLeft -= c;
+    }
+    ProtLeft = (ProtLeft + r > ProtEdgesCap) ? ProtEdgesCap : ProtLeft + r;
+#endif
+    for (a = 0; a < AxisCount; a++)
+    {
+#if SpeedMode != SpeedTimer1
+        ProtEdges[a] += r;              // One ADDWF: no edge is lost on high_isr
+        if (ProtEdges[a] > ProtEdgesCap)
+        {
+            ProtEdges[a] = ProtEdgesCap;    // An edge between the test and this store is forgiven
+        }
+#endif
+        if (ProtWindow == 0)
+        {
+            ProtIllegal[a] = ProtIllegalMax;
+        }
+        if (EncoderPos[a] != ProtLastPos[a] || Duty[a] < ProtStallDuty)
+        {
+            ProtLastPos[a] = EncoderPos[a];
+            ProtIdle[a] = 0;
+        }
+        else if ((ProtIdle[a] += n) >= ProtStallMs)
+        {
+            code = ProtAxis(a) | ProtStall;
+        }
+    }
+    ProtEdgesOn();
+    if (code != 0)
+    {
+        INTCONbits.GIEH = 0;            // high_isr may trip too: first fault wins
+        ProtTrip(code);
+        INTCONbits.GIEH = 1;
+    }
+}
+
+/*******************************
+ * ProtClear(void)
+ *
+ * Clears the latched fault and turns the PWM back on, with every loop still
+ * held open at zero duty: a speed or duty command starts the motors again.
+ * Called by the low priority ISR (CmdApply). The budgets are refilled before
+ * the fault is cleared, so high_isr does not trip again on what it counted
+ * down while the fault was latched.
+ *******************************/
+void ProtClear(void)
+{
+    unsigned char a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        ControlHold(a, 0);
+    }
+    ProtRefill();
+    ProtFault = 0;
+    HalPWMOn();
+}
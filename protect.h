@@ -0,0 +1,117 @@
+/*
+ * File:   protect.h
+ *
+ * Motor protection: stall, overspeed and encoder loss turn the PWM off and
+ * latch a fault code until it is cleared by command (CmdFault). The edge
+ * driven checks of SpeedEdgeISR run in high_isr as one byte budget per axis
+ * that the 1 ms tick refills: every edge takes one from ProtEdges (an illegal
+ * or empty RB change too), every illegal transition one from ProtIllegal, and
+ * the edge that empties a budget cuts the PWM itself, whatever the low
+ * priority ISR is busy with; emptying ProtEdges also masks RB change for the
+ * rest of the tick, so the low priority ISR still runs (encoder.h). ProtEdges
+ * gets ProtEdgesMs added for every Timer2 period since the last tick, so
+ * ticks that high_isr merged are paid for, up to ProtEdgesCap. The
+ * ProtEdgesSlack edges over one tick's worth cover a tick that runs late,
+ * behind the sample tick branch that high_isr stretches to about 0.5 ms at
+ * the limit: fewer, and the limit speed itself trips. So the cut comes once
+ * the shaft has run ProtEdgesSlack edges more than the limit allows: 2 ms at
+ * 25% over, longer for a shaft that creeps past it (12.8 ms in make -C sim
+ * faults, where the motor ramps through the limit with its 50 ms time
+ * constant). SpeedMT spends the same budget on every channel A capture
+ * (ReadCapture), which also trips when the captures crowd out the tick.
+ * SpeedTimer1 counts channel A in hardware with no interrupt, so ProtTick
+ * takes the Timer1 count since the tick before off the budget itself and
+ * reacts as fast. A stall has no edges to count, so ProtTick looks for it on
+ * the tick: duty applied and the position still for twice the edge gap at
+ * ProtMinRPS, and ProtStallSlack more. A loaded shaft held at that speed
+ * needs ProtStallDuty and more, and must not read as stalled between its
+ * edges or while the loop hunts round the duty that just turns it (make -C
+ * sim crawl; a 5 ms window tripped there); a real stall is cut ProtStallMs
+ * after it began (40 ms in make -C sim faults). The cut turns the CCP modules off (HalPWMOff), which drops the
+ * pins to their port latch, held low; while the fault is latched ProtTick
+ * also holds every loop open at zero duty and ends any move, so clearing it
+ * does not restart the motors.
+ *
+ * ProtFault: fault code in bits 3:0, axis in bits 5:4, 0 while none.
+ */
+
+#ifndef PROTECT_H
+#define	PROTECT_H
+
+#define ProtStall 1             // Duty at ProtStallDuty or more, no edge for ProtStallMs
+#define ProtOverspeed 2         // More than ProtEdgesMs edges per tick, for longer than ProtEdgesCap covers
+#define ProtEncoder 3           // ProtIllegalMax illegal transitions in one ProtWindowMs
+#define ProtAxis(a) ((a) << 4)
+
+// The limit is where the encoder input still leaves the low priority ticks
+// their time. SpeedEdgeISR: high_isr takes 74% of the CPU at 8 rev/s on one
+// axis and 81% at 4 rev/s on two (main.c). SpeedMT: a low priority capture
+// per channel A rising edge, about 60% at 30 rev/s (make -C sim sweep
+// DEFS=-DSpeedMode=2). SpeedTimer1 costs nothing per edge, so the limit is
+// the motor's: 50 rev/s (3000 RPM).
+#ifndef ProtMaxRPS
+#if SpeedMode == SpeedTimer1
+#define ProtMaxRPS 50000L       // Overspeed limit, milli-rev/s
+#elif SpeedMode == SpeedMT
+#define ProtMaxRPS 30000L       // Overspeed limit, milli-rev/s, where the captures still leave the ticks time
+#elif EncoderSampled
+#define ProtMaxRPS 4000L        // Overspeed limit, milli-rev/s, where the sampled input still keeps up
+#elif AxisCount > 1
+#define ProtMaxRPS 4000L        // Overspeed limit, milli-rev/s, two axes sharing high_isr
+#else
+#define ProtMaxRPS 8000L        // Overspeed limit, milli-rev/s
+#endif
+#endif
+#if SpeedMode == SpeedEdgeISR
+#define ProtEdgesRev EncoderCPR // Edges per revolution the budget counts: every quadrature edge
+#else
+#define ProtEdgesRev EncoderLines // ... channel A rising edges only
+#endif
+#define ProtEdgesMs ((ProtMaxRPS*ProtEdgesRev)/(RPSScale*1000L)) // ... as edges per 1 ms tick
+#define ProtEdgesSlack (ProtEdgesMs > 16 ? ProtEdgesMs/2 : 8) // Edges a late tick may run over (0.5 ms at the limit, 8 at least)
+#define ProtEdgesCap (ProtEdgesMs + ProtEdgesSlack) // Most the budget holds
+#define ProtIllegalMax 4        // Illegal transitions in one window that mean the encoder is lost
+#define ProtWindowMs 10         // ... window (ticks)
+#define ProtStallDuty 40        // A little above the duty the motor needs to start (deadband)
+#ifndef ProtMinRPS
+#define ProtMinRPS 50L          // Slowest speed a loop is expected to hold, milli-rev/s (3 RPM)
+#endif
+#define ProtGapMs ((RPSScale*1000L + ProtMinRPS*ProtEdgesRev - 1)/(ProtMinRPS*ProtEdgesRev)) // Ticks between edges there (10)
+#define ProtStallSlack 20       // Ticks more for a loaded loop hunting round that speed to get moving again
+#if SpeedMode == SpeedTimer1 && !SpeedObserver
+#define ProtStallMs (2*ProtGapMs + ProtStallSlack + SpeedTickMs) // ... and EncoderPos only moves on the sample tick
+#else
+#define ProtStallMs (2*ProtGapMs + ProtStallSlack) // Ticks with no edge at ProtStallDuty or more that mean a stall
+#endif
+
+#if ProtEdgesMs < 2
+#error "ProtMaxRPS must give at least 2 edges per tick"
+#endif
+#if ProtMinRPS < 1 || ProtStallMs > 200
+#error "ProtMinRPS must give a stall window of at most 200 ticks (one byte count)"
+#endif
+#if SpeedMode != SpeedTimer1 && 2*ProtEdgesCap > 255
+#error "ProtMaxRPS must give at most 119 edges per tick (one byte budget, counted down per edge)"
+#endif
+
+extern volatile unsigned char ProtFault;
+extern volatile unsigned char ProtEdges[AxisCount];
+extern volatile unsigned char ProtIllegal[AxisCount];
+
+// Latch code unless a fault is latched already, then cut the PWM. Byte
+// operations only, for high_isr; low priority callers mask it (ProtTick).
+#define ProtTrip(code)  do { if (ProtFault == 0) { ProtFault = (code); } \
+                             HalPWMOff(); } while (0)
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void ProtInit(void);
+
+void ProtTick(unsigned char n);
+
+void ProtClear(void);
+
+
+#endif	/* PROTECT_H */
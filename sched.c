@@ -0,0 +1,119 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "hal.h"
+#include "sched.h"
+
+/******************************************************************************/
+/* Scheduler Variables                                                        */
+/******************************************************************************/
+
+volatile unsigned char SchedTicks;  // Timer2 ticks, free running (ISR)
+unsigned int SchedTime;             // Scheduler time, ticks (main loop)
+SchedTask SchedTasks[SchedMaxTasks];// Task table
+unsigned char SchedCount;           // Tasks in the table
+
+static unsigned char SchedSeen;     // SchedTicks already added to SchedTime
+
+/******************************************************************************/
+/* Scheduler Functions                                                        */
+/******************************************************************************/
+
+/*******************************
+ * SchedInit(void)
+ *
+ * Empties the task table. Call before the Timer2 interrupt is enabled.
+ *******************************/
+void SchedInit(void)
+{
+    SchedTicks = 0;
+    SchedSeen = 0;
+    SchedTime = 0;
+    SchedCount = 0;
+}
+
+/*******************************
+ * SchedAdd(void (*run)(void), unsigned int period, unsigned int offset)
+ *
+ * Adds a task released every period ticks, the first time offset ticks from
+ * now. Offsets spread tasks with the same period over different ticks.
+ * Returns the task index, or SchedMaxTasks if the table is full.
+ *******************************/
+unsigned char SchedAdd(void (*run)(void), unsigned int period, unsigned int offset)
+{
+    SchedTask * t;
+
+    if (SchedCount >= SchedMaxTasks)
+    {
+        return SchedMaxTasks;
+    }
+    t = &SchedTasks[SchedCount];
+    t->Run = run;
+    t->Period = period;
+    t->Next = SchedTime + offset;
+    t->Overruns = 0;
+    t->MaxLate = 0;
+    return SchedCount++;
+}
+
+/*******************************
+ * SchedRun(void)
+ *
+ * The main loop; never returns. Brings SchedTime up to date from the one byte
+ * tick counter (a single byte read, so no interrupt masking), then runs every
+ * task that is due, in table order. A task that starts a whole period or more
+ * after its release has missed releases: they are counted in Overruns and
+ * skipped, so a slow task is not run back to back to catch up. When nothing
+ * is due the loop idles until the next tick. The PIC18F452 has no IDLE mode
+ * and SLEEP stops the oscillator and with it Timer2, so HalIdle only waits.
+ *******************************/
+void SchedRun(void)
+{
+    unsigned char i;
+    unsigned char ran;
+    unsigned char now;
+    unsigned int late;
+    SchedTask * t;
+
+    while (1)
+    {
+        now = SchedTicks;
+        SchedTime += (unsigned char)(now - SchedSeen);
+        SchedSeen = now;
+
+        ran = 0;
+        for (i = 0; i < SchedCount; i++)
+        {
+            t = &SchedTasks[i];
+            late = SchedTime - t->Next;
+            if (late >= 0x8000)             // Not due yet (negative)
+            {
+                continue;
+            }
+            if (late > t->MaxLate)
+            {
+                t->MaxLate = late;
+            }
+            if (late >= t->Period)          // Missed whole periods
+            {
+                t->Overruns += late / t->Period;
+                t->Next += (late / t->Period) * t->Period;
+            }
+            t->Next += t->Period;
+            t->Run();
+            ran = 1;
+        }
+
+        if (ran == 0)
+        {
+            while (SchedTicks == SchedSeen)
+            {
+                HalIdle();                  // Nothing due until the next tick
+            }
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*
+ * File:   sched.h
+ *
+ * Cooperative run-to-completion scheduler for the main loop. The Timer2
+ * interrupt counts 1 ms ticks in SchedTicks; SchedRun releases each task when
+ * its period has elapsed and waits for the next tick when nothing is due.
+ * Tasks run in the order they were added, so add the most urgent first.
+ */
+
+#ifndef SCHED_H
+#define	SCHED_H
+
+#define SchedMaxTasks 6         // Size of the task table (main stops at start up on a full one)
+
+typedef struct
+{
+    void (*Run)(void);          // Task body, runs to completion
+    unsigned int Period;        // Release period, ticks (ms)
+    unsigned int Next;          // SchedTime of the next release
+    unsigned int Overruns;      // Releases skipped because the task started a period or more late
+    unsigned int MaxLate;       // Longest delay from release to start, ticks
+} SchedTask;
+
+extern volatile unsigned char SchedTicks;   // Timer2 ticks, free running (ISR)
+extern unsigned int SchedTime;              // Scheduler time, ticks (main loop)
+extern SchedTask SchedTasks[SchedMaxTasks];
+extern unsigned char SchedCount;
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void SchedInit(void);
+
+unsigned char SchedAdd(void (*run)(void), unsigned int period, unsigned int offset);
+
+void SchedRun(void);
+
+
+#endif	/* SCHED_H */
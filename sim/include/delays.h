@@ -0,0 +1,17 @@
+/* 
+ * File:   delays.h (host simulator)
+ *
+ * Peripheral library delays. Each one runs the simulation for the requested
+ * number of instruction cycles of main line code.
+ */
+
+#ifndef SIM_DELAYS_H
+#define	SIM_DELAYS_H
+
+void Delay10TCYx(unsigned char unit);
+void Delay100TCYx(unsigned char unit);
+void Delay1KTCYx(unsigned char unit);
+void Delay10KTCYx(unsigned char unit);
+
+
+#endif	/* SIM_DELAYS_H */
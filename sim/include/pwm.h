@@ -0,0 +1,5 @@
+/* 
+ * File:   pwm.h (host simulator)
+ *
+ * The firmware drives CCP1 through its registers; nothing is needed here.
+ */
@@ -0,0 +1,19 @@
+/* 
+ * File:   timers.h (host simulator)
+ *
+ * Peripheral library timer access, backed by the simulated timers.
+ */
+
+#ifndef SIM_TIMERS_H
+#define	SIM_TIMERS_H
+
+void WriteTimer0(unsigned int timer0);
+unsigned int ReadTimer0(void);
+void CloseTimer0(void);
+void WriteTimer1(unsigned int timer1);
+unsigned int ReadTimer1(void);
+void WriteTimer3(unsigned int timer3);
+unsigned int ReadTimer3(void);
+
+
+#endif	/* SIM_TIMERS_H */
@@ -0,0 +1,114 @@
+/* 
+ * File:   xc.h (host simulator)
+ *
+ * Stands in for the XC8 device header in the host build. Every SFR the
+ * firmware uses is a plain byte in sfr.c with a matching bit-field view, so
+ * the firmware compiles unchanged and the simulator reads and writes the
+ * same bytes. Interrupt qualifiers are dropped; sim.c calls the ISRs.
+ */
+
+#ifndef SIM_XC_H
+#define	SIM_XC_H
+
+#define interrupt
+#define high_priority
+#define low_priority
+
+#define NOP()
+#define CLRWDT()
+#define SLEEP()         SimSleep()
+#define di()            (INTCONbits.GIEH = 0)
+#define ei()            (INTCONbits.GIEH = 1)
+
+void SimSleep(void);
+
+#define SIM_SFR(name)   extern volatile unsigned char name;
+#define SIM_BITS(name, ...) \
+    typedef struct { unsigned char __VA_ARGS__; } name##bits_t;
+#define SIM_VIEW(name)  (*(volatile name##bits_t *)&name)
+
+SIM_SFR(PORTA) SIM_BITS(PORTA, RA0:1, RA1:1, RA2:1, RA3:1, RA4:1, RA5:1, RA6:1, :1)
+SIM_SFR(PORTB) SIM_BITS(PORTB, RB0:1, RB1:1, RB2:1, RB3:1, RB4:1, RB5:1, RB6:1, RB7:1)
+SIM_SFR(PORTC) SIM_BITS(PORTC, RC0:1, RC1:1, RC2:1, RC3:1, RC4:1, RC5:1, RC6:1, RC7:1)
+SIM_SFR(PORTD) SIM_BITS(PORTD, RD0:1, RD1:1, RD2:1, RD3:1, RD4:1, RD5:1, RD6:1, RD7:1)
+SIM_SFR(PORTE) SIM_BITS(PORTE, RE0:1, RE1:1, RE2:1, :5)
+SIM_SFR(LATA)
+SIM_SFR(LATB)  SIM_BITS(LATB, LATB0:1, LATB1:1, LATB2:1, LATB3:1, LATB4:1, LATB5:1, LATB6:1, LATB7:1)
+SIM_SFR(LATC)
+SIM_SFR(LATD)
+SIM_SFR(LATE)
+SIM_SFR(TRISA)
+SIM_SFR(TRISB) SIM_BITS(TRISB, RB0:1, RB1:1, RB2:1, RB3:1, RB4:1, RB5:1, RB6:1, RB7:1)
+SIM_SFR(TRISC) SIM_BITS(TRISC, RC0:1, RC1:1, RC2:1, RC3:1, RC4:1, RC5:1, RC6:1, RC7:1)
+SIM_SFR(TRISD)
+SIM_SFR(TRISE)
+SIM_SFR(INTCON)
+typedef union {
+    struct { unsigned char RBIF:1, INT0IF:1, TMR0IF:1, RBIE:1, INT0IE:1, TMR0IE:1, GIEL:1, GIEH:1; };
+    struct { unsigned char :1, INT0F:1, T0IF:1, :1, INT0E:1, T0IE:1, PEIE:1, GIE:1; };
+} INTCONbits_t;
+SIM_SFR(INTCON2) SIM_BITS(INTCON2, RBIP:1, :1, TMR0IP:1, :1, INTEDG2:1, INTEDG1:1, INTEDG0:1, NOT_RBPU:1)
+SIM_SFR(INTCON3) SIM_BITS(INTCON3, INT1IF:1, INT2IF:1, :1, INT1IE:1, INT2IE:1, :1, INT1IP:1, INT2IP:1)
+SIM_SFR(RCON)  SIM_BITS(RCON, NOT_BOR:1, NOT_POR:1, NOT_PD:1, NOT_TO:1, NOT_RI:1, :2, IPEN:1)
+SIM_SFR(PIR1)  SIM_BITS(PIR1, TMR1IF:1, TMR2IF:1, CCP1IF:1, SSPIF:1, TXIF:1, RCIF:1, ADIF:1, PSPIF:1)
+SIM_SFR(PIE1)  SIM_BITS(PIE1, TMR1IE:1, TMR2IE:1, CCP1IE:1, SSPIE:1, TXIE:1, RCIE:1, ADIE:1, PSPIE:1)
+SIM_SFR(IPR1)  SIM_BITS(IPR1, TMR1IP:1, TMR2IP:1, CCP1IP:1, SSPIP:1, TXIP:1, RCIP:1, ADIP:1, PSPIP:1)
+SIM_SFR(PIR2)  SIM_BITS(PIR2, CCP2IF:1, TMR3IF:1, LVDIF:1, BCLIF:1, EEIF:1, :3)
+SIM_SFR(PIE2)  SIM_BITS(PIE2, CCP2IE:1, TMR3IE:1, LVDIE:1, BCLIE:1, EEIE:1, :3)
+SIM_SFR(IPR2)  SIM_BITS(IPR2, CCP2IP:1, TMR3IP:1, LVDIP:1, BCLIP:1, EEIP:1, :3)
+SIM_SFR(T0CON) SIM_BITS(T0CON, T0PS0:1, T0PS1:1, T0PS2:1, PSA:1, T0SE:1, T0CS:1, T08BIT:1, TMR0ON:1)
+SIM_SFR(T1CON) SIM_BITS(T1CON, TMR1ON:1, TMR1CS:1, NOT_T1SYNC:1, T1OSCEN:1, T1CKPS0:1, T1CKPS1:1, :1, RD16:1)
+SIM_SFR(T2CON) SIM_BITS(T2CON, T2CKPS0:1, T2CKPS1:1, TMR2ON:1, T2OUTPS0:1, T2OUTPS1:1, T2OUTPS2:1, T2OUTPS3:1, :1)
+SIM_SFR(T3CON) SIM_BITS(T3CON, TMR3ON:1, TMR3CS:1, NOT_T3SYNC:1, T3CCP1:1, T3CKPS0:1, T3CKPS1:1, T3CCP2:1, RD16:1)
+SIM_SFR(PR2)
+SIM_SFR(CCP1CON) SIM_BITS(CCP1CON, CCP1M0:1, CCP1M1:1, CCP1M2:1, CCP1M3:1, DC1B0:1, DC1B1:1, :2)
+SIM_SFR(CCPR1L)
+SIM_SFR(CCPR1H)
+SIM_SFR(CCP2CON) SIM_BITS(CCP2CON, CCP2M0:1, CCP2M1:1, CCP2M2:1, CCP2M3:1, DC2B0:1, DC2B1:1, :2)
+SIM_SFR(CCPR2L)
+SIM_SFR(CCPR2H)
+SIM_SFR(TXSTA) SIM_BITS(TXSTA, TX9D:1, TRMT:1, BRGH:1, :1, SYNC:1, TXEN:1, TX9:1, CSRC:1)
+SIM_SFR(RCSTA) SIM_BITS(RCSTA, RX9D:1, OERR:1, FERR:1, ADDEN:1, CREN:1, SREN:1, RX9:1, SPEN:1)
+SIM_SFR(SPBRG)
+SIM_SFR(TXREG)
+SIM_SFR(RCREG)
+SIM_SFR(EECON1) SIM_BITS(EECON1, RD:1, WR:1, WREN:1, WRERR:1, FREE:1, :1, CFGS:1, EEPGD:1)
+SIM_SFR(EECON2)
+SIM_SFR(EEADR)
+SIM_SFR(EEDATA)
+SIM_SFR(ADCON1)
+SIM_SFR(OSCCON)
+SIM_SFR(STKPTR)
+
+#define PORTAbits   SIM_VIEW(PORTA)
+#define PORTBbits   SIM_VIEW(PORTB)
+#define PORTCbits   SIM_VIEW(PORTC)
+#define PORTDbits   SIM_VIEW(PORTD)
+#define PORTEbits   SIM_VIEW(PORTE)
+#define LATBbits    SIM_VIEW(LATB)
+#define TRISBbits   SIM_VIEW(TRISB)
+#define TRISCbits   SIM_VIEW(TRISC)
+#define INTCONbits  SIM_VIEW(INTCON)
+#define INTCON2bits SIM_VIEW(INTCON2)
+#define INTCON3bits SIM_VIEW(INTCON3)
+#define RCONbits    SIM_VIEW(RCON)
+#define PIR1bits    SIM_VIEW(PIR1)
+#define PIE1bits    SIM_VIEW(PIE1)
+#define IPR1bits    SIM_VIEW(IPR1)
+#define PIR2bits    SIM_VIEW(PIR2)
+#define PIE2bits    SIM_VIEW(PIE2)
+#define IPR2bits    SIM_VIEW(IPR2)
+#define T0CONbits   SIM_VIEW(T0CON)
+#define T1CONbits   SIM_VIEW(T1CON)
+#define T2CONbits   SIM_VIEW(T2CON)
+#define T3CONbits   SIM_VIEW(T3CON)
+#define CCP1CONbits SIM_VIEW(CCP1CON)
+#define CCP2CONbits SIM_VIEW(CCP2CON)
+#define TXSTAbits   SIM_VIEW(TXSTA)
+#define RCSTAbits   SIM_VIEW(RCSTA)
+#define EECON1bits  SIM_VIEW(EECON1)
+
+#define LATB4       (LATBbits.LATB4)
+
+
+#endif	/* SIM_XC_H */
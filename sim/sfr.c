@@ -0,0 +1,20 @@
+/******************************************************************************/
+/* Simulated SFR image                                                        */
+/******************************************************************************/
+
+#include <xc.h>
+
+#undef SIM_SFR
+#define SIM_SFR(name)   volatile unsigned char name;
+
+SIM_SFR(PORTA) SIM_SFR(PORTB) SIM_SFR(PORTC) SIM_SFR(PORTD) SIM_SFR(PORTE)
+SIM_SFR(LATA) SIM_SFR(LATB) SIM_SFR(LATC) SIM_SFR(LATD) SIM_SFR(LATE)
+SIM_SFR(TRISA) SIM_SFR(TRISB) SIM_SFR(TRISC) SIM_SFR(TRISD) SIM_SFR(TRISE)
+SIM_SFR(INTCON) SIM_SFR(INTCON2) SIM_SFR(INTCON3) SIM_SFR(RCON)
+SIM_SFR(PIR1) SIM_SFR(PIE1) SIM_SFR(IPR1) SIM_SFR(PIR2) SIM_SFR(PIE2) SIM_SFR(IPR2)
+SIM_SFR(T0CON) SIM_SFR(T1CON) SIM_SFR(T2CON) SIM_SFR(T3CON) SIM_SFR(PR2)
+SIM_SFR(CCP1CON) SIM_SFR(CCPR1L) SIM_SFR(CCPR1H)
+SIM_SFR(CCP2CON) SIM_SFR(CCPR2L) SIM_SFR(CCPR2H)
+SIM_SFR(TXSTA) SIM_SFR(RCSTA) SIM_SFR(SPBRG) SIM_SFR(TXREG) SIM_SFR(RCREG)
+SIM_SFR(EECON1) SIM_SFR(EECON2) SIM_SFR(EEADR) SIM_SFR(EEDATA)
+SIM_SFR(ADCON1) SIM_SFR(OSCCON) SIM_SFR(STKPTR)
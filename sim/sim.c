@@ -0,0 +1,1369 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <xc.h>
+#include "system.h"
+#include "globals.h"
+#include "control.h"
+#include "speed.h"
+#include "observer.h"
+#include "protect.h"
+#include "profile.h"
+#include "user.h"
+#include "sched.h"
+#include "telemetry.h"
+#include "capture.h"
+#include "sim.h"
+
+/******************************************************************************/
+/* Simulator Settings and State                                               */
+/******************************************************************************/
+
+#define SimFcy          (SYS_FREQ/4)            // Instruction cycles per second
+#define SimNever        (~(SimTime)0)
+#define SimMotorStep    (SimFcy/1000)           // Motor model update (1 ms)
+
+// high_isr cycles by path, as counted in main.c: context save and restore
+// (66) and the body of a call that decodes one edge (RB change) or none
+// (sampled). Added to it: an edge that passes the filter, the capture record.
+#define SimHighBase     (AxisCount > 1 ? 126 : 115)
+#define SimHighEdge     14                      // EncoderSampled: EdgeDiff not 0
+#define SimHighCap      82                      // CapOn at entry
+
+static double OptSeconds = 10.0;    // -t  simulated run time (s)
+static double OptForcedRPS = 0.0;   // -r  drive the encoders at a fixed speed (rev/s)
+static int OptForced = 0;
+static double OptKm = 60.0;         // -k  motor speed at 100% duty (rev/s)
+static double OptTau = 0.05;        // -T  motor time constant (s)
+static double OptDeadband = 0.05;   // -d  duty fraction below which the motor stalls
+static double OptLoad = 0.0;        // -D  constant load, as a speed drop (rev/s)
+static unsigned OptIsrEdge = 80;    // -E  cycles per short ISR call (RB change, CCP2, USART byte)
+static const char * OptTxFile;      // -u  write the USART output to this file
+static const char * OptEEFile;      // -e  data EEPROM image, loaded at reset and saved at the end
+static const char * OptRxFile;      // -c  bytes to send to the USART receiver, by time (see SimRxLoad)
+static double OptGlitchRate = 0.0;  // -g  encoder glitches per second, at random times on random channels
+static double OptGlitchWidth = 25.0;// -w  glitch length (instruction cycles)
+static const char * OptFault;       // -F  fault on axis 0: stall, over, short, open (see SimFault)
+static double OptFaultAt = 2.0;     // -f  ... from this time (s)
+static unsigned OptIsrLow = 300;    // -L  cycles per other low priority ISR call
+static unsigned OptIsrHigh = SimHighBase; // -H  cycles per high priority ISR call (see SimCost)
+
+SimTime SimNow;                     // Current time (instruction cycles)
+static SimTime SimEnd;              // Stop and report here
+
+// Motors and encoders, one per axis
+static double Theta0[AxisCount];    // Shaft position (encoder counts) at ThetaTime
+static SimTime ThetaTime[AxisCount];
+static double Omega[AxisCount];     // Shaft speed (counts per cycle)
+static long TrueCount[AxisCount];   // floor of the shaft position in counts
+static SimTime NextEdge[AxisCount];
+static SimTime NextMotor;
+static unsigned long Edges;
+static long LostBase[AxisCount];    // TrueCount - EncoderPos when interrupts came on
+static int Started;
+static const unsigned char Gray[4] = {0x0, 0x2, 0x3, 0x1}; // A in bit 1, B in bit 0
+static unsigned char GlitchMask;    // PORTB pins inverted by a glitch in progress
+static SimTime GlitchNext = SimNever; // Next glitch starts
+static SimTime GlitchEnd = SimNever;  // Glitch in progress ends
+static unsigned long Glitches;
+static int FaultKind;                // Index of OptFault in FaultNames, 0 for none
+static const char * const FaultNames[] = {"none", "stall", "over", "short", "open"};
+static SimTime FaultStart = SimNever; // Injected fault begins (-f)
+static SimTime FaultHit = SimNever; // ... took effect: shaft locked, limit crossed, pins wrong
+static SimTime PwmOffAt = SimNever; // CCP1 first left PWM mode
+static double PwmOffRPS;            // ... shaft 0 speed then (rev/s)
+static int PwmWasOn;
+
+// Interrupts
+static SimTime LowBusy;             // Low priority ISR running until
+static SimTime HighBusy;            // High priority ISR running until
+static unsigned long LowCalls;
+static unsigned long HighCalls;
+static SimTime LowCycles;
+static SimTime HighCycles;
+static int InIsr;                   // An ISR is running: Timer3 reads see its cost so far
+static unsigned char IsrIntcon;     // Flags at ISR entry
+static unsigned char IsrPir1;
+static unsigned char IsrPir2;
+static unsigned char IsrPie1;
+static unsigned IsrBase;
+static int IsrHigh;                 // The running ISR is the high priority one
+static int IsrCap;                  // ... and the capture was on at its entry
+
+// Timers
+static int T0On;
+static SimTime T0Start;
+static unsigned long T0Base;
+static SimTime T0Next;
+static int T2On;
+static SimTime T2Next;
+static unsigned int T1Count;        // Timer1 counting T13CKI edges
+static int T1On;                    // Timer1 on the instruction clock
+static SimTime T1Start;
+static unsigned long T1Base;
+static int T3On;
+static SimTime T3Start;
+static unsigned long T3Base;
+static unsigned char CCP2Div;
+
+// USART
+static FILE * TxFile;
+static SimTime TxDone;              // Shift register empties
+static unsigned char TxShift;       // Byte being shifted out
+static unsigned char TxHold;        // Byte waiting in TXREG
+static int TxHeld;
+static int TxShort;                 // The running ISR wrote TXREG or read RCREG
+static unsigned long TxBytes;
+static SimTime * RxAt;              // Receive script: earliest start of each byte
+static unsigned char * RxData;      // ... and the byte
+static size_t RxCount;
+static size_t RxIndex;              // Next byte of the script
+static SimTime RxNext = SimNever;   // Start bit of the next byte, or its stop bit when RxShifting
+static int RxShifting;
+static unsigned char RxFifo[2];     // Two byte receive FIFO, RCREG reads the oldest
+static int RxFill;
+static unsigned long RxBytes;
+static unsigned long RxOverruns;    // Bytes lost with the FIFO full
+
+// Data EEPROM
+#define SimEEWriteTime  (SimFcy/250)            // 4 ms per byte
+static unsigned char EERom[256];
+static unsigned long EEWrites[256];
+static SimTime EEDone = SimNever;   // Write in progress completes
+static unsigned char EEAddr;
+static unsigned char EEData;
+static unsigned long EEErrors;      // Writes started while one was in progress
+
+// HD44780 LCD
+static char LCDRam[128];
+static unsigned char LCDAddr;
+static unsigned char LCDMode8 = 1;
+static unsigned char LCDPhase;
+static unsigned char LCDHigh;
+
+/******************************************************************************/
+/* Timers                                                                     */
+/******************************************************************************/
+
+static unsigned long SimT0Prescale(void)
+{
+    return T0CONbits.PSA ? 1 : 2UL << (T0CON & 0x07);
+}
+
+static unsigned long SimT0Range(void)
+{
+    return T0CONbits.T08BIT ? 256UL : 65536UL;
+}
+
+static SimTime SimT2Period(void)
+{
+    unsigned long pre = T2CONbits.T2CKPS1 ? 16 : (T2CONbits.T2CKPS0 ? 4 : 1);
+    unsigned long post = ((T2CON >> 3) & 0x0F) + 1;
+    return (SimTime)(PR2 + 1) * pre * post;
+}
+
+static unsigned long SimT1Prescale(void)
+{
+    return 1UL << ((T1CON >> 4) & 0x03);
+}
+
+static unsigned long SimT3Prescale(void)
+{
+    return 1UL << ((T3CON >> 4) & 0x03);
+}
+
+void WriteTimer0(unsigned int timer0)
+{
+    T0Base = timer0;
+    T0Start = SimNow;
+    T0Base &= SimT0Range() - 1;
+    T0Next = T0On ? T0Start + (SimT0Range() - T0Base) * SimT0Prescale() : SimNever;
+}
+
+unsigned int ReadTimer0(void)
+{
+    if (!T0On)
+    {
+        return (unsigned int)T0Base;
+    }
+    return (unsigned int)((T0Base + (SimNow - T0Start) / SimT0Prescale()) & (SimT0Range() - 1));
+}
+
+void CloseTimer0(void)
+{
+    T0CONbits.TMR0ON = 0;
+    INTCONbits.TMR0IE = 0;
+}
+
+void WriteTimer1(unsigned int timer1)
+{
+    T1Count = timer1;
+    T1Base = timer1;
+    T1Start = SimNow;
+}
+
+static unsigned SimElapsed(void);
+
+unsigned int ReadTimer1(void)
+{
+    if (!T1On)
+    {
+        return T1Count;
+    }
+    return (unsigned int)((T1Base + (SimNow + SimElapsed() - T1Start) / SimT1Prescale()) & 0xFFFF);
+}
+
+/*******************************
+ * SimTimer2: TMR2 read, the count since the last period match (T2Next is
+ * the next one)
+ *******************************/
+unsigned char SimTimer2(void)
+{
+    unsigned long pre = T2CONbits.T2CKPS1 ? 16 : (T2CONbits.T2CKPS0 ? 4 : 1);
+    SimTime period = (SimTime)(PR2 + 1) * pre;
+
+    if (!T2On)
+    {
+        return 0;
+    }
+    return (unsigned char)(((SimNow + SimElapsed() + SimT2Period() - T2Next) % period) / pre);
+}
+
+void WriteTimer3(unsigned int timer3)
+{
+    T3Base = timer3;
+    T3Start = SimNow;
+}
+
+unsigned int ReadTimer3(void)
+{
+    if (!T3On)
+    {
+        return (unsigned int)T3Base;
+    }
+    return (unsigned int)((T3Base + (SimNow + SimElapsed() - T3Start) / SimT3Prescale()) & 0xFFFF);
+}
+
+/*******************************
+ * SimSync: pick up timers the firmware switched on or off
+ *******************************/
+static void SimSync(void)
+{
+    int on;
+    int a;
+
+    on = T0CONbits.TMR0ON && !T0CONbits.T0CS;
+    if (on && !T0On)
+    {
+        T0On = 1;
+        WriteTimer0((unsigned int)T0Base);
+    }
+    else if (!on && T0On)
+    {
+        T0Base = ReadTimer0();
+        T0On = 0;
+        T0Next = SimNever;
+    }
+
+    on = T2CONbits.TMR2ON;
+    if (on && !T2On)
+    {
+        T2Next = SimNow + SimT2Period();
+    }
+    T2On = on;
+
+    if (!Started && INTCONbits.GIEH && INTCONbits.GIEL)
+    {
+        Started = 1;                        // Firmware starts counting here
+        for (a = 0; a < AxisCount; a++)
+        {
+            LostBase[a] = TrueCount[a] - EncoderPos[a];
+        }
+    }
+
+    on = T1CONbits.TMR1ON && !T1CONbits.TMR1CS;
+    if (on && !T1On)
+    {
+        T1Base = T1Count;
+        T1Start = SimNow;
+    }
+    else if (!on && T1On)
+    {
+        T1Count = ReadTimer1();
+    }
+    T1On = on;
+
+    on = T3CONbits.TMR3ON && !T3CONbits.TMR3CS;
+    if (on && !T3On)
+    {
+        T3Start = SimNow;
+    }
+    else if (!on && T3On)
+    {
+        T3Base = ReadTimer3();
+    }
+    T3On = on;
+
+    if (TXSTAbits.TXEN && RCSTAbits.SPEN && !TxHeld)
+    {
+        PIR1bits.TXIF = 1;                  // TXREG empty
+    }
+}
+
+/******************************************************************************/
+/* Motor and Encoder                                                          */
+/******************************************************************************/
+
+static double SimPosition(int a, SimTime t)
+{
+    return Theta0[a] + Omega[a] * (double)(t - ThetaTime[a]);
+}
+
+static void SimNextEdge(int a)
+{
+    double target;
+    double dt;
+
+    if (Omega[a] > 0)
+    {
+        target = (double)(TrueCount[a] + 1);
+        dt = (target - Theta0[a]) / Omega[a];
+    }
+    else if (Omega[a] < 0)
+    {
+        target = (double)TrueCount[a];
+        dt = (Theta0[a] - target) / -Omega[a];
+    }
+    else
+    {
+        NextEdge[a] = SimNever;
+        return;
+    }
+    if (dt < 0)
+    {
+        dt = 0;
+    }
+    if (dt >= (double)(SimEnd - ThetaTime[a]))
+    {
+        NextEdge[a] = SimNever;             // Not before the end (a shaft all but stopped would overflow)
+        return;
+    }
+    NextEdge[a] = ThetaTime[a] + (SimTime)ceil(dt);
+    if (NextEdge[a] < SimNow)
+    {
+        NextEdge[a] = SimNow;
+    }
+}
+
+static void SimCapture2(void)
+{
+    unsigned int t = (T3CONbits.T3CCP1 || T3CONbits.T3CCP2) ? ReadTimer3() : ReadTimer1();
+
+    CCPR2L = (unsigned char)t;
+    CCPR2H = (unsigned char)(t >> 8);
+    PIR2bits.CCP2IF = 1;
+}
+
+/*******************************
+ * SimEdge: move encoder a one count and update the pins and peripherals.
+ * Axis 0 is on RB5:RB4 and also feeds T13CKI and CCP2, axis 1 is on RB7:RB6.
+ *******************************/
+static void SimEdge(int a)
+{
+    unsigned char old = Gray[TrueCount[a] & 3];
+    unsigned char now;
+    unsigned char mode = CCP2CON & 0x0F;
+    int shift = 4 + 2*a;
+
+    TrueCount[a] += (Omega[a] > 0) ? 1 : -1;
+    now = Gray[TrueCount[a] & 3];
+    if (a == 0 && FaultKind >= 3 && SimNow >= FaultStart)
+    {
+        if (FaultHit == SimNever)
+        {
+            FaultHit = SimNow;
+        }
+        now = (FaultKind == 4 || (now & 2)) ? 3 : 0; // open: pulled up; short: B follows A
+    }
+    PORTB = (unsigned char)((PORTB & ~(0x03 << shift)) | ((now << shift) ^ (GlitchMask & (0x03 << shift))));
+    INTCONbits.RBIF = 1;                    // Change on RB7:RB4
+    Edges++;
+    if (a != 0)
+    {
+        return;
+    }
+
+    if (!(old & 2) && (now & 2))            // Channel A rising
+    {
+        if (T1CONbits.TMR1ON && T1CONbits.TMR1CS)
+        {
+            if (++T1Count == 0)
+            {
+                PIR1bits.TMR1IF = 1;
+            }
+        }
+        if (mode == 0x05 || (mode == 0x06 && (++CCP2Div & 3) == 0) ||
+            (mode == 0x07 && (++CCP2Div & 15) == 0))
+        {
+            SimCapture2();
+        }
+    }
+    else if ((old & 2) && !(now & 2) && mode == 0x04)
+    {
+        SimCapture2();                      // Channel A falling
+    }
+}
+
+/*******************************
+ * SimGlitchAfter: time of the next glitch, exponentially distributed gaps
+ * at OptGlitchRate
+ *******************************/
+static SimTime SimGlitchAfter(SimTime t)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return t + (SimTime)(-log(u) / OptGlitchRate * SimFcy) + 1;
+}
+
+/*******************************
+ * SimGlitch: starts or ends a glitch, a short pulse on one encoder pin
+ * (RB7:RB4, of any axis) that the shaft did not make. The pins only: Timer1
+ * and CCP2 see the clean channel A. One glitch at a time.
+ *******************************/
+static void SimGlitch(void)
+{
+    if (GlitchEnd <= SimNow)
+    {
+        PORTB ^= GlitchMask;
+        GlitchMask = 0;
+        GlitchEnd = SimNever;
+    }
+    else
+    {
+        GlitchMask = (unsigned char)(0x10 << (rand() % (2 * AxisCount)));
+        PORTB ^= GlitchMask;
+        GlitchEnd = SimNow + (SimTime)OptGlitchWidth;
+        GlitchNext = SimGlitchAfter(GlitchEnd);
+        Glitches++;
+    }
+    INTCONbits.RBIF = 1;                    // Change on RB7:RB4
+}
+
+/*******************************
+ * SimFault: the injected fault (-F) takes effect on the motor of axis 0 at
+ * its first update from -f on. stall locks the shaft, over drives it towards
+ * 1.25 ProtMaxRPS whatever the PWM does (an overhauling load), short ties channel
+ * B to A and open lets both float high (these two in SimEdge and here, so the
+ * pins change even with the shaft still). FaultHit is when the stall began,
+ * the speed passed ProtMaxRPS, or the pins first went wrong.
+ *******************************/
+static void SimFault(double * target, double * a)
+{
+    if (FaultKind == 1)
+    {
+        *target = 0.0;
+        *a = 0.0;
+        FaultHit = (FaultHit == SimNever) ? SimNow : FaultHit;
+    }
+    else if (FaultKind == 2)
+    {
+        *target = 1.25 * ProtMaxRPS / RPSScale;
+        if (FaultHit == SimNever && Omega[0] * SimFcy / EncoderCPR * RPSScale > ProtMaxRPS)
+        {
+            FaultHit = SimNow;
+        }
+    }
+    else if (FaultKind == 4 && ((PORTB >> 4) & 3) != 3)
+    {
+        PORTB |= 0x30;                      // Both pins of axis 0 high
+        INTCONbits.RBIF = 1;
+        FaultHit = (FaultHit == SimNever) ? SimNow : FaultHit;
+    }
+}
+
+/*******************************
+ * SimMotor: first order DC motor of axis ax driven by its PWM duty, CCP1
+ * for axis 0 and CCP2 for axis 1
+ *******************************/
+static void SimMotor(int ax)
+{
+    double frac = 0.0;
+    double target;
+    double a;
+    unsigned int duty;
+    unsigned char con = ax ? CCP2CON : CCP1CON;
+    unsigned char high = ax ? CCPR2L : CCPR1L;
+
+    Theta0[ax] = SimPosition(ax, SimNow);
+    ThetaTime[ax] = SimNow;
+
+    if (OptForced)
+    {
+        target = OptForcedRPS;
+        a = 0.0;
+    }
+    else
+    {
+        if ((con & 0x0C) == 0x0C && T2On)
+        {
+            duty = ((unsigned int)high << 2) | ((con >> 4) & 0x03);
+            frac = duty / (4.0 * (PR2 + 1));
+            if (frac > 1.0)
+            {
+                frac = 1.0;
+            }
+        }
+        target = (frac <= OptDeadband) ? 0.0 : OptKm * (frac - OptDeadband) / (1.0 - OptDeadband);
+        target = (target > OptLoad) ? target - OptLoad : 0.0;
+        a = exp(-(double)SimMotorStep / (OptTau * SimFcy));
+        if (ax == 0 && SimNow >= FaultStart)
+        {
+            SimFault(&target, &a);
+        }
+    }
+    target *= (double)EncoderCPR / SimFcy;  // rev/s to counts per cycle
+    Omega[ax] = target + (Omega[ax] - target) * a;
+    SimNextEdge(ax);
+}
+
+/******************************************************************************/
+/* USART                                                                      */
+/******************************************************************************/
+
+static SimTime SimBitTime(void)
+{
+    return (SimTime)(SPBRG + 1) * (TXSTAbits.BRGH ? 4 : 16);
+}
+
+static void SimTxStart(unsigned char b, SimTime start)
+{
+    TxShift = b;
+    TxDone = start + 10 * SimBitTime();     // Start, 8 data, stop
+    TXSTAbits.TRMT = 0;
+}
+
+/*******************************
+ * SimTxByte: TXREG write. Goes straight to the shift register if it is
+ * empty, otherwise waits in TXREG with TXIF low.
+ *******************************/
+void SimTxByte(unsigned char b)
+{
+    TXREG = b;
+    TxShort = 1;
+    if (!RCSTAbits.SPEN || !TXSTAbits.TXEN)
+    {
+        return;
+    }
+    if (TxDone == SimNever)
+    {
+        SimTxStart(b, SimNow);
+    }
+    else
+    {
+        TxHold = b;
+        TxHeld = 1;
+        PIR1bits.TXIF = 0;
+    }
+}
+
+static void SimTxDone(void)
+{
+    if (TxFile != NULL)
+    {
+        fputc(TxShift, TxFile);
+    }
+    TxBytes++;
+    if (TxHeld)
+    {
+        TxHeld = 0;
+        SimTxStart(TxHold, TxDone);
+        PIR1bits.TXIF = 1;
+    }
+    else
+    {
+        TxDone = SimNever;
+        TXSTAbits.TRMT = 1;
+    }
+}
+
+/*******************************
+ * SimRxNext: start the next scripted byte at its time, or right after the
+ * one before it
+ *******************************/
+static void SimRxNext(SimTime after)
+{
+    RxShifting = 0;
+    RxNext = SimNever;
+    if (RxIndex < RxCount)
+    {
+        RxNext = (RxAt[RxIndex] > after) ? RxAt[RxIndex] : after;
+    }
+}
+
+/*******************************
+ * SimRxEvent: a start bit (the length of the byte is known from SPBRG only
+ * now), or a complete byte into the FIFO. With the receiver off the byte is
+ * lost on the line; with the FIFO full it is an overrun. OERR itself is not
+ * modelled, as the firmware clears it with a CREN write the simulator does
+ * not see.
+ *******************************/
+static void SimRxEvent(void)
+{
+    if (!RxShifting)
+    {
+        RxShifting = 1;
+        RxNext += 10 * SimBitTime();        // Start, 8 data, stop
+        return;
+    }
+    if (RCSTAbits.SPEN && RCSTAbits.CREN)
+    {
+        if (RxFill < 2)
+        {
+            RxFifo[RxFill++] = RxData[RxIndex];
+            PIR1bits.RCIF = 1;
+            RxBytes++;
+        }
+        else
+        {
+            RxOverruns++;
+        }
+    }
+    RxIndex++;
+    SimRxNext(RxNext);
+}
+
+/*******************************
+ * SimRxByte: RCREG read. Pops the FIFO; RCIF stays set while a byte is left.
+ *******************************/
+unsigned char SimRxByte(void)
+{
+    TxShort = 1;
+    if (RxFill == 0)
+    {
+        return RCREG;
+    }
+    RCREG = RxFifo[0];
+    RxFifo[0] = RxFifo[1];
+    RxFill--;
+    PIR1bits.RCIF = (RxFill != 0);
+    return RCREG;
+}
+
+/*******************************
+ * SimRxLoad: reads the receive script, one line per burst of bytes:
+ * the time in seconds, then the bytes in hex ("1.5 c3 81 00 d0 07 00 00 4e",
+ * as written by tools/cmdsend -t). The bytes of a line are sent back to back
+ * from that time. Blank lines and lines starting with # are skipped.
+ *******************************/
+static void SimRxLoad(const char * name)
+{
+    FILE * f = fopen(name, "r");
+    char line[512];
+    char * p;
+    char * end;
+    double t;
+    unsigned long b;
+    size_t size = 0;
+
+    if (f == NULL)
+    {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+    while (fgets(line, sizeof line, f) != NULL)
+    {
+        t = strtod(line, &end);
+        if (end == line || line[0] == '#')
+        {
+            continue;
+        }
+        for (p = end; (b = strtoul(p, &end, 16)), end != p; p = end)
+        {
+            if (RxCount == size)
+            {
+                size = size ? 2 * size : 64;
+                RxAt = realloc(RxAt, size * sizeof RxAt[0]);
+                RxData = realloc(RxData, size);
+                if (RxAt == NULL || RxData == NULL)
+                {
+                    perror("realloc");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            RxAt[RxCount] = (SimTime)(t * SimFcy);
+            RxData[RxCount++] = (unsigned char)b;
+        }
+    }
+    fclose(f);
+    SimRxNext(0);
+}
+
+/******************************************************************************/
+/* Data EEPROM                                                                */
+/******************************************************************************/
+
+unsigned char SimEERead(unsigned char addr)
+{
+    EEADR = addr;
+    EEDATA = EERom[addr];
+    return EEDATA;
+}
+
+/*******************************
+ * SimEEWrite: start a byte write. WR stays set for 4 ms, then the byte is
+ * stored and EEIF set. Starting a write while one is in progress is counted
+ * as an error (the chip would lose it).
+ *******************************/
+void SimEEWrite(unsigned char addr, unsigned char data)
+{
+    EEADR = addr;
+    EEDATA = data;
+    if (EEDone != SimNever)
+    {
+        EEErrors++;
+        return;
+    }
+    EEAddr = addr;
+    EEData = data;
+    EECON1bits.WR = 1;
+    EEDone = SimNow + SimEEWriteTime;
+}
+
+static void SimEEDone(void)
+{
+    EERom[EEAddr] = EEData;
+    EEWrites[EEAddr]++;
+    EECON1bits.WR = 0;
+    PIR2bits.EEIF = 1;
+    EEDone = SimNever;
+}
+
+static void SimEEFile(int save)
+{
+    FILE * f;
+
+    if (OptEEFile == NULL)
+    {
+        return;
+    }
+    f = fopen(OptEEFile, save ? "wb" : "rb");
+    if (f == NULL)
+    {
+        if (save)
+        {
+            perror(OptEEFile);
+        }
+        return;                             // No image yet: blank EEPROM
+    }
+    if (save)
+    {
+        fwrite(EERom, 1, sizeof EERom, f);
+    }
+    else if (fread(EERom, 1, sizeof EERom, f) != sizeof EERom)
+    {
+        fprintf(stderr, "%s: short EEPROM image\n", OptEEFile);
+    }
+    fclose(f);
+}
+
+/******************************************************************************/
+/* HD44780 LCD                                                                */
+/******************************************************************************/
+
+static void SimLCDByte(unsigned char rs, unsigned char b)
+{
+    if (rs)
+    {
+        LCDRam[LCDAddr & 0x7F] = (char)b;
+        LCDAddr++;
+    }
+    else if (b == 0x01)                     // Clear display
+    {
+        memset(LCDRam, ' ', sizeof LCDRam);
+        LCDAddr = 0;
+    }
+    else if (b & 0x80)                      // Set DDRAM address
+    {
+        LCDAddr = b & 0x7F;
+    }
+}
+
+void SimLCDNibble(unsigned char rs, unsigned char nib)
+{
+    nib &= 0xF0;
+    if (LCDMode8)                           // Power up: 8 bit, one command per strobe
+    {
+        if ((nib & 0xF0) == 0x20)
+        {
+            LCDMode8 = 0;                   // Function set, 4 bit
+            LCDPhase = 0;
+        }
+        return;
+    }
+    if (LCDPhase == 0)
+    {
+        LCDHigh = nib;
+        LCDPhase = 1;
+    }
+    else
+    {
+        LCDPhase = 0;
+        SimLCDByte(rs, (unsigned char)(LCDHigh | (nib >> 4)));
+    }
+}
+
+/******************************************************************************/
+/* Interrupts and Time                                                        */
+/******************************************************************************/
+
+/*******************************
+ * SimPending(int high): an enabled interrupt of the given priority is flagged
+ *******************************/
+static int SimPending(int high)
+{
+    int ipen = RCONbits.IPEN;
+
+#define SIM_SOURCE(flag, enable, prio) \
+    if ((flag) && (enable) && (ipen ? ((prio) != 0) == high : high)) return 1;
+
+    SIM_SOURCE(INTCONbits.INT0IF, INTCONbits.INT0IE, 1)
+    SIM_SOURCE(INTCONbits.RBIF, INTCONbits.RBIE, INTCON2bits.RBIP)
+    SIM_SOURCE(INTCONbits.TMR0IF, INTCONbits.TMR0IE, INTCON2bits.TMR0IP)
+    SIM_SOURCE(PIR1bits.TMR1IF, PIE1bits.TMR1IE, IPR1bits.TMR1IP)
+    SIM_SOURCE(PIR1bits.TMR2IF, PIE1bits.TMR2IE, IPR1bits.TMR2IP)
+    SIM_SOURCE(PIR1bits.CCP1IF, PIE1bits.CCP1IE, IPR1bits.CCP1IP)
+    SIM_SOURCE(PIR1bits.TXIF, PIE1bits.TXIE, IPR1bits.TXIP)
+    SIM_SOURCE(PIR1bits.RCIF, PIE1bits.RCIE, IPR1bits.RCIP)
+    SIM_SOURCE(PIR2bits.CCP2IF, PIE2bits.CCP2IE, IPR2bits.CCP2IP)
+    SIM_SOURCE(PIR2bits.TMR3IF, PIE2bits.TMR3IE, IPR2bits.TMR3IP)
+    SIM_SOURCE(PIR2bits.EEIF, PIE2bits.EEIE, IPR2bits.EEIP)
+#undef SIM_SOURCE
+    return 0;
+}
+
+/*******************************
+ * SimCost: cycles charged for the ISR call in progress, by what it serviced.
+ * A high priority call is OptIsrHigh plus the longer paths it took.
+ *******************************/
+static unsigned SimCost(void)
+{
+    if (IsrHigh)
+    {
+        return IsrBase + (EncoderSampled && EdgeDiff != 0 ? SimHighEdge : 0) + (IsrCap ? SimHighCap : 0);
+    }
+    if (((IsrIntcon & ~INTCON) & 0x01) || TxShort || ((IsrPie1 & ~PIE1) & 0x10) ||
+        (((IsrPir2 & ~PIR2) & 0x01) && (CCP2CON & 0x0F) != 0x0B))
+    {
+        return OptIsrEdge;                  // RBIF, CCP2IF capture or a USART byte serviced
+    }
+    return IsrBase;
+}
+
+/*******************************
+ * SimElapsed: cycles the running ISR has used so far. The cost of a call is
+ * charged once it has cleared a flag, so a timer read at ISR entry sees 0
+ * and one at the end of a branch sees the branch cost.
+ *******************************/
+static unsigned SimElapsed(void)
+{
+    if (!InIsr || (((IsrIntcon & ~INTCON) & 0x07) == 0 && (IsrPir1 & ~PIR1) == 0 &&
+                   (IsrPir2 & ~PIR2) == 0 && !TxShort))
+    {
+        return 0;
+    }
+    return SimCost();
+}
+
+/*******************************
+ * SimIsr: call an ISR with its entry flags noted for SimCost and SimElapsed
+ *******************************/
+static unsigned SimIsr(void (*isr)(void), unsigned base, int high)
+{
+    IsrIntcon = INTCON;
+    IsrPir1 = PIR1;
+    IsrPir2 = PIR2;
+    IsrPie1 = PIE1;
+    IsrBase = base;
+    IsrHigh = high;
+    IsrCap = high && CapOn != 0;
+    TxShort = 0;
+    InIsr = 1;
+    isr();
+    InIsr = 0;
+    return SimCost();
+}
+
+/*******************************
+ * SimPwmWatch: notes when CCP1 first leaves PWM mode, at the end of the ISR
+ * call of the given cost that turned it off
+ *******************************/
+static void SimPwmWatch(unsigned cost)
+{
+    if ((CCP1CON & 0x0C) == 0x0C)
+    {
+        PwmWasOn = 1;
+    }
+    else if (PwmWasOn && PwmOffAt == SimNever)
+    {
+        PwmOffAt = SimNow + cost;
+        PwmOffRPS = Omega[0] * SimFcy / EncoderCPR;
+    }
+}
+
+/*******************************
+ * SimDispatch: run one ISR if one may run now. High priority preempts low.
+ *******************************/
+static int SimDispatch(void)
+{
+    unsigned cost;
+
+    if (!INTCONbits.GIEH || SimNow < HighBusy)
+    {
+        return 0;
+    }
+    if (SimPending(1))
+    {
+        cost = SimIsr(high_isr, OptIsrHigh, 1);
+        HighCalls++;
+        HighCycles += cost;
+        HighBusy = SimNow + cost;
+        if (LowBusy > SimNow)
+        {
+            LowBusy += cost;                // Preempted low priority ISR
+        }
+        SimPwmWatch(cost);
+        SimSync();
+        return 1;
+    }
+    if (RCONbits.IPEN && INTCONbits.GIEL && SimNow >= LowBusy && SimPending(0))
+    {
+        cost = SimIsr(low_isr, OptIsrLow, 0);
+        LowCalls++;
+        LowCycles += cost;
+        LowBusy = SimNow + cost;
+        SimPwmWatch(cost);
+        SimSync();
+        return 1;
+    }
+    return 0;
+}
+
+static void SimReport(void);
+
+/*******************************
+ * SimCompare2: time of the next CCP2 special event trigger (compare mode
+ * 1011), when the timer selected by T3CCP2:T3CCP1 runs past CCPR2 and is
+ * reset by the hardware. Worked out from the timer state every time, so
+ * firmware writes to the timer or CCPR2 need no re-arming.
+ *******************************/
+static SimTime SimCompare2(void)
+{
+    unsigned int cmp = (unsigned int)(CCPR2H << 8 | CCPR2L);
+
+    if ((CCP2CON & 0x0F) != 0x0B)
+    {
+        return SimNever;
+    }
+    if (T3CONbits.T3CCP1 || T3CONbits.T3CCP2)
+    {
+        return T3On ? T3Start + (((cmp - T3Base) & 0xFFFF) + 1) * SimT3Prescale() : SimNever;
+    }
+    return T1On ? T1Start + (((cmp - T1Base) & 0xFFFF) + 1) * SimT1Prescale() : SimNever;
+}
+
+/*******************************
+ * SimStep(SimTime limit): advance to the next event (or limit) and handle it
+ *******************************/
+static void SimStep(SimTime limit)
+{
+    SimTime t = limit;
+    SimTime c = SimCompare2();
+    int a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        if (NextEdge[a] < t) t = NextEdge[a];
+    }
+    if (c < t) t = c;
+    if (T0On && T0Next < t) t = T0Next;
+    if (T2On && T2Next < t) t = T2Next;
+    if (NextMotor < t) t = NextMotor;
+    if (TxDone < t) t = TxDone;
+    if (RxNext < t) t = RxNext;
+    if (GlitchNext < t) t = GlitchNext;
+    if (GlitchEnd < t) t = GlitchEnd;
+    if (EEDone < t) t = EEDone;
+    if (SimEnd < t) t = SimEnd;
+    if (t < SimNow) t = SimNow;
+    SimNow = t;
+
+    if (SimNow >= SimEnd)
+    {
+        SimReport();
+        exit(EXIT_SUCCESS);
+    }
+    if (NextMotor <= SimNow)
+    {
+        for (a = 0; a < AxisCount; a++)
+        {
+            SimMotor(a);
+        }
+        NextMotor += SimMotorStep;
+    }
+    for (a = 0; a < AxisCount; a++)
+    {
+        while (NextEdge[a] <= SimNow)
+        {
+            SimEdge(a);
+            SimNextEdge(a);
+            if (NextEdge[a] == SimNow)
+            {
+                NextEdge[a]++;              // At most one count per cycle
+            }
+        }
+    }
+    if (T0On && T0Next <= SimNow)
+    {
+        INTCONbits.TMR0IF = 1;
+        T0Base = 0;
+        T0Start = T0Next;
+        T0Next = T0Start + SimT0Range() * SimT0Prescale();
+    }
+    if (c <= SimNow)
+    {
+        PIR2bits.CCP2IF = 1;                // Special event: the timer restarts from 0
+        if (T3CONbits.T3CCP1 || T3CONbits.T3CCP2)
+        {
+            T3Base = 0;
+            T3Start = c;
+        }
+        else
+        {
+            T1Base = 0;
+            T1Start = c;
+        }
+    }
+    if (T2On && T2Next <= SimNow)
+    {
+        PIR1bits.TMR2IF = 1;
+        T2Next += SimT2Period();
+    }
+    if (TxDone <= SimNow)
+    {
+        SimTxDone();
+    }
+    if (RxNext <= SimNow)
+    {
+        SimRxEvent();
+    }
+    if (GlitchEnd <= SimNow || GlitchNext <= SimNow)
+    {
+        SimGlitch();
+    }
+    if (EEDone <= SimNow)
+    {
+        SimEEDone();
+    }
+}
+
+static SimTime SimBusy(void)
+{
+    return (LowBusy > HighBusy) ? LowBusy : HighBusy;
+}
+
+/*******************************
+ * SimRunMain(unsigned long cycles)
+ *
+ * Runs the simulation until main line code has had cycles instruction cycles.
+ * Time spent in ISRs does not count, as on the chip.
+ *******************************/
+void SimRunMain(unsigned long cycles)
+{
+    SimTime left = cycles;
+    SimTime t;
+
+    SimSync();
+    while (left > 0)
+    {
+        if (SimDispatch())
+        {
+            continue;
+        }
+        if (SimBusy() > SimNow)
+        {
+            SimStep(SimBusy());
+            continue;
+        }
+        t = SimNow + left;
+        SimStep(t);
+        left = (SimNow < t) ? t - SimNow : 0;
+    }
+}
+
+/*******************************
+ * SimSleep(void): wait until an interrupt has been serviced
+ *******************************/
+void SimSleep(void)
+{
+    SimSync();
+    while (!SimDispatch())
+    {
+        SimStep(SimBusy() > SimNow ? SimBusy() : SimNever);
+    }
+}
+
+void Delay10TCYx(unsigned char unit)
+{
+    SimRunMain(10UL * (unit ? unit : 256));
+}
+
+void Delay100TCYx(unsigned char unit)
+{
+    SimRunMain(100UL * (unit ? unit : 256));
+}
+
+void Delay1KTCYx(unsigned char unit)
+{
+    SimRunMain(1000UL * (unit ? unit : 256));
+}
+
+void Delay10KTCYx(unsigned char unit)
+{
+    SimRunMain(10000UL * (unit ? unit : 256));
+}
+
+/******************************************************************************/
+/* Harness                                                                    */
+/******************************************************************************/
+
+#if ISRProfile
+static void SimHist(const char * name, const unsigned int * hist, unsigned shift)
+{
+    int i;
+
+    printf("  %-4s", name);
+    for (i = 0; i < ProfBins; i++)
+    {
+        if (hist[i] != 0)
+        {
+            printf(" <%lu:%u", (i < ProfBins-1 ? 1UL << i : 65536UL) << shift, hist[i]);
+        }
+    }
+    printf("\n");
+}
+
+/*******************************
+ * SimReportProfile: ISR timing statistics gathered by the firmware
+ *******************************/
+static void SimReportProfile(void)
+{
+    static const char * const name[ProfBranches] = {"edge", "tmr0", "tmr2", "high"};
+    const ProfStat * s;
+    int b;
+
+    printf("profile     cycles min/mean/max, gap max, log2 histograms (<limit:count)\n");
+    for (b = 0; b < ProfBranches; b++)
+    {
+        s = &ProfStats[b];
+        if (s->Calls == 0)
+        {
+            continue;
+        }
+        printf("%-11s %u/%lu/%u, gap max %u\n", name[b], s->Min << ProfShift,
+               (s->Sum / s->Calls) << ProfShift, s->Max << ProfShift, s->GapMax << ProfShift);
+        SimHist("dur", s->Dur, ProfShift);
+        SimHist("gap", s->Gap, ProfShift);
+    }
+    printf("tmr0 lat    max %u\n", ProfLatMax);
+    SimHist("lat", ProfLat, 0);
+}
+#endif
+
+static void SimReport(void)
+{
+    double secs = (double)SimNow / SimFcy;
+    unsigned i;
+    unsigned long eeTotal = 0;
+    unsigned long eeMax = 0;
+    char n[4];
+    int a;
+
+#if SpeedMode == SpeedEdgeISR
+    ReadEncoder();                          // Fold edges latched since the last tick
+#endif
+    printf("time        %.3f s\n", secs);
+    for (a = 0; a < AxisCount; a++)         // Axis 1 lines are labelled "shaft 1" etc.
+    {
+        snprintf(n, sizeof n, a ? " %d" : "", a);
+        printf("shaft%-7s%.3f rev/s, %ld counts\n", n, Omega[a] * SimFcy / EncoderCPR, TrueCount[a]);
+        printf("firmware%-4sRPS %.3f rev/s, EncoderPos %ld, errors %u, missed %u\n", n,
+               RPS[a] / (double)RPSScale, EncoderPos[a], EncoderErrors[a], EncoderMissed[a]);
+        printf("lost%-8s%ld counts\n", n, TrueCount[a] - EncoderPos[a] - LostBase[a]);
+        printf("duty%-8s%u/%u, setpoint %.3f rev/s\n", n, Duty[a], DutyMax, SetRPS[a] / (double)RPSScale);
+    }
+    printf("edges       %lu (%.0f/s)\n", Edges, Edges / secs);
+    if (Glitches != 0)
+    {
+        printf("glitches    %lu (%.0f/s, %.0f cycles)\n", Glitches, Glitches / secs, OptGlitchWidth);
+    }
+    if (TxBytes != 0)
+    {
+        printf("usart       %lu bytes (%.0f/s)\n", TxBytes, TxBytes / secs);
+    }
+    if (RxCount != 0)
+    {
+        printf("usart rx    %lu of %lu bytes, %lu overruns\n", RxBytes, (unsigned long)RxCount, RxOverruns);
+    }
+    for (i = 0; i < sizeof EEWrites / sizeof EEWrites[0]; i++)
+    {
+        eeTotal += EEWrites[i];
+        if (EEWrites[i] > eeMax)
+        {
+            eeMax = EEWrites[i];
+        }
+    }
+    if (eeTotal != 0 || EEErrors != 0)
+    {
+        printf("eeprom      %lu byte writes, %lu max on one byte, %lu overlapped\n",
+               eeTotal, eeMax, EEErrors);
+    }
+    SimEEFile(1);
+    for (i = 0; i < SchedCount; i++)
+    {
+        printf("task %u      every %u ms, late max %u ms, overruns %u\n", i,
+               SchedTasks[i].Period, SchedTasks[i].MaxLate, SchedTasks[i].Overruns);
+    }
+    printf("protection  fault 0x%02x", ProtFault);
+    if (PwmOffAt != SimNever)
+    {
+        printf(", pwm off at %.4f s, %.2f rev/s", (double)PwmOffAt / SimFcy, PwmOffRPS);
+    }
+    if (FaultHit != SimNever)
+    {
+        printf(", %s at %.4f s", FaultNames[FaultKind], (double)FaultHit / SimFcy);
+        if (PwmOffAt != SimNever && PwmOffAt >= FaultHit)
+        {
+            printf(", reaction %.3f ms", 1000.0 * (PwmOffAt - FaultHit) / SimFcy);
+        }
+        else if (PwmOffAt != SimNever)
+        {
+            printf(", off %.3f ms before", 1000.0 * (FaultHit - PwmOffAt) / SimFcy);
+        }
+    }
+    printf("\n");
+    printf("isr low     %lu calls, %.1f%% cpu\n", LowCalls, 100.0 * LowCycles / SimNow);
+    printf("isr high    %lu calls, %.1f%% cpu\n", HighCalls, 100.0 * HighCycles / SimNow);
+    printf("lcd         [%.16s]\n            [%.16s]\n", LCDRam, LCDRam + 0x40);
+#if ISRProfile
+    SimReportProfile();
+#endif
+    fflush(stdout);
+}
+
+static void SimReset(void)
+{
+    int a;
+
+    memset(LCDRam, ' ', sizeof LCDRam);
+    memset(EERom, 0xFF, sizeof EERom);      // Blank
+    SimEEFile(0);
+    TRISA = TRISB = TRISC = TRISD = TRISE = 0xFF;   // Power on reset values
+    T0CON = 0xFF;
+    INTCON2 = 0xF5;
+    IPR1 = 0xFF;
+    IPR2 = 0x1F;
+    PORTB = (unsigned char)(Gray[0] << 4);
+    T0Next = T2Next = SimNever;
+    for (a = 0; a < AxisCount; a++)
+    {
+        NextEdge[a] = SimNever;
+        Theta0[a] = 0.5 * a;                // Axis 1 half a count out of phase: edges interleave
+    }
+    NextMotor = 0;
+    TxDone = SimNever;
+    TXSTAbits.TRMT = 1;
+}
+
+static void SimUsage(const char * prog)
+{
+    fprintf(stderr,
+        "usage: %s [-t seconds] [-r rps] [-k rps_at_full_duty] [-T tau_s]\n"
+        "          [-d deadband] [-D load_rps] [-E edge_isr_cycles] [-L low_isr_cycles]\n"
+        "          [-H high_isr_cycles] [-u usart_out_file] [-e eeprom_image]\n"
+        "          [-c usart_in_script] [-g glitches_per_s] [-w glitch_cycles]\n"
+        "          [-F stall|over|short|open] [-f fault_s]\n",
+        prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char * argv[])
+{
+    int c;
+
+    while ((c = getopt(argc, argv, "t:r:k:T:d:D:E:L:H:u:e:c:g:w:F:f:")) != -1)
+    {
+        switch (c)
+        {
+            case 't': OptSeconds = atof(optarg); break;
+            case 'r': OptForcedRPS = atof(optarg); OptForced = 1; break;
+            case 'k': OptKm = atof(optarg); break;
+            case 'T': OptTau = atof(optarg); break;
+            case 'd': OptDeadband = atof(optarg); break;
+            case 'D': OptLoad = atof(optarg); break;
+            case 'E': OptIsrEdge = (unsigned)atoi(optarg); break;
+            case 'L': OptIsrLow = (unsigned)atoi(optarg); break;
+            case 'H': OptIsrHigh = (unsigned)atoi(optarg); break;
+            case 'u': OptTxFile = optarg; break;
+            case 'e': OptEEFile = optarg; break;
+            case 'c': OptRxFile = optarg; break;
+            case 'g': OptGlitchRate = atof(optarg); break;
+            case 'w': OptGlitchWidth = atof(optarg); break;
+            case 'F': OptFault = optarg; break;
+            case 'f': OptFaultAt = atof(optarg); break;
+            default: SimUsage(argv[0]);
+        }
+    }
+    if (OptSeconds <= 0 || OptIsrEdge == 0 || OptIsrLow == 0 || OptIsrHigh == 0 || OptTau <= 0 ||
+        OptGlitchRate < 0 || OptGlitchWidth < 1)
+    {
+        SimUsage(argv[0]);
+    }
+    for (c = 1; OptFault != NULL && c < (int)(sizeof FaultNames / sizeof FaultNames[0]); c++)
+    {
+        if (strcmp(OptFault, FaultNames[c]) == 0)
+        {
+            FaultKind = c;
+            FaultStart = (SimTime)(OptFaultAt * SimFcy);
+        }
+    }
+    if (OptFault != NULL && FaultKind == 0)
+    {
+        SimUsage(argv[0]);
+    }
+    SimEnd = (SimTime)(OptSeconds * SimFcy);
+    if (OptTxFile != NULL && (TxFile = fopen(OptTxFile, "wb")) == NULL)
+    {
+        perror(OptTxFile);
+        return EXIT_FAILURE;
+    }
+    SimReset();
+    if (OptRxFile != NULL)
+    {
+        SimRxLoad(OptRxFile);
+    }
+    if (OptGlitchRate > 0)
+    {
+        srand(1);                           // The same glitches every run
+        GlitchNext = SimGlitchAfter(0);
+    }
+
+    FirmwareMain();
+    SimReport();
+    return 0;
+}
@@ -0,0 +1,46 @@
+/* 
+ * File:   sim.h
+ *
+ * Host simulator of the PIC18F452 board: DC motor and 500 line encoder,
+ * Timer0/1/2/3, CCP2 capture and special event trigger, the USART, the data EEPROM, the
+ * HD44780 LCD and interrupt dispatch. Time is counted in instruction cycles and only advances
+ * while the firmware waits (Delay*TCYx, SLEEP) or while an interrupt is being
+ * serviced.
+ */
+
+#ifndef SIM_H
+#define	SIM_H
+
+typedef unsigned long long SimTime;     // Instruction cycles since reset
+
+extern SimTime SimNow;
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void SimRunMain(unsigned long cycles);
+
+void SimSleep(void);
+
+void SimLCDNibble(unsigned char rs, unsigned char nib);
+
+void SimTxByte(unsigned char b);
+
+unsigned char SimRxByte(void);
+
+unsigned char SimTimer2(void);
+
+unsigned char SimEERead(unsigned char addr);
+
+void SimEEWrite(unsigned char addr, unsigned char data);
+
+// Firmware entry points linked from main.c
+int FirmwareMain(void);
+
+void high_isr(void);
+
+void low_isr(void);
+
+
+#endif	/* SIM_H */
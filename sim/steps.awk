@@ -0,0 +1,46 @@
+#
+#  Setpoint step check for make -C sim steps, over the tools/tlmdecode CSV
+#  of a run. steps lists each step as time_ms:milli-rev/s, from a 1 rev/s
+#  start. Per step it prints the settling time, from the step command to the
+#  last frame outside 2% of the new setpoint, and the overshoot past the new
+#  setpoint as a percent of the step. Exits 1 if a step takes longer than
+#  settle ms or overshoots by more than limit percent.
+#
+#     awk -F, -v steps="2000:5000 7000:2000" -v settle=4000 -v limit=5 -f steps.awk run.csv
+#
+
+BEGIN {
+    n = split(steps, s, " ")
+    for (i = 1; i <= n; i++)
+    {
+        split(s[i], f, ":")
+        at[i] = f[1]
+        to[i] = f[2] / 1000
+        from[i] = (i == 1) ? 1 : to[i-1]
+    }
+    at[n+1] = 1e9
+}
+
+NR > 1 {
+    for (i = 1; i <= n && $2 >= at[i+1]; i++)
+        ;
+    if (i > n || $2 < at[i])
+        next
+    o = ($4 - to[i]) / (to[i] - from[i]) * 100
+    if (o > over[i])
+        over[i] = o
+    if ($4 < 0.98 * to[i] || $4 > 1.02 * to[i])
+        last[i] = $2
+}
+
+END {
+    for (i = 1; i <= n; i++)
+    {
+        ms = last[i] + 10 - at[i]       # Telemetry frames are 10 ms apart
+        bad = (ms > settle || over[i] > limit)
+        fail += bad
+        printf "%5.2f -> %5.2f rev/s  settled %4d ms, overshoot %4.1f%%%s\n",
+               from[i], to[i], ms, over[i], bad ? "  FAIL" : ""
+    }
+    exit (fail != 0)
+}
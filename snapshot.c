@@ -0,0 +1,66 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include "globals.h"
+#include "control.h"
+#include "snapshot.h"
+
+/******************************************************************************/
+/* Snapshot Variables                                                         */
+/******************************************************************************/
+
+volatile unsigned char SnapSeq;         // Odd while SnapPublish is writing
+static volatile SpeedSnap SnapBuf;      // Last published set
+
+/******************************************************************************/
+/* Snapshot Functions                                                         */
+/******************************************************************************/
+
+/*******************************
+ * SnapPublish(void)
+ *
+ * Called by the low priority ISR at the end of every Timer2 tick, after the
+ * edges are folded and the speed loop has run. Bumps SnapSeq to odd, copies
+ * the set, and bumps it back to even. Only ISRs write the fields, and this
+ * runs at low priority, so the set cannot change under the copy.
+ *******************************/
+void SnapPublish(void)
+{
+    unsigned char a;
+
+    SnapSeq++;                          // Odd: update in progress
+    SnapBuf.Time++;
+    for (a = 0; a < AxisCount; a++)
+    {
+        SnapBuf.Pos[a] = EncoderPos[a];
+        SnapBuf.RPS[a] = RPS[a];
+        SnapBuf.Count[a] = CHAcount[a];
+        SnapBuf.Duty[a] = Duty[a];
+    }
+    SnapSeq++;                          // Even: consistent again
+}
+
+/*******************************
+ * SnapRead(SpeedSnap * s)
+ *
+ * Main loop side. Copies the published set into s byte by byte and repeats
+ * the copy if SnapSeq was odd or moved meanwhile, i.e. if SnapPublish ran
+ * during the copy. The copy takes a few tens of cycles against a 1 ms
+ * publication period, so a retry is rare and a second one rarer still.
+ *******************************/
+void SnapRead(SpeedSnap * s)
+{
+    unsigned char seq;
+    unsigned char i;
+
+    do
+    {
+        seq = SnapSeq;
+        for (i = 0; i < sizeof(SpeedSnap); i++)
+        {
+            SnapByteHook(i);
+            ((unsigned char *)s)[i] = ((volatile unsigned char *)&SnapBuf)[i];
+        }
+    } while ((seq & 1) != 0 || seq != SnapSeq);
+}
@@ -0,0 +1,39 @@
+/*
+ * File:   snapshot.h
+ *
+ * Consistent copy of the ISR maintained speed state for the main loop. The
+ * Timer2 ISR publishes the set under a one byte sequence counter; readers
+ * retry until the counter is even and unchanged across their copy, so they
+ * never see a half updated long and never mask interrupts. Every axis is
+ * in the one set, so their values are from the same tick. No SFR
+ * dependencies, so it also builds on the host (tools/snapstress.c).
+ */
+
+#ifndef SNAPSHOT_H
+#define	SNAPSHOT_H
+
+typedef struct
+{
+    unsigned int Time;          // Timer2 ticks (ms) at publication, wraps
+    long Pos[AxisCount];        // EncoderPos (quadrature counts)
+    long RPS[AxisCount];        // RPS (milli-rev/s)
+    long Count[AxisCount];      // CHAcount, counts over the sliding sample window
+    unsigned int Duty[AxisCount]; // Duty written by the speed loop this tick
+} SpeedSnap;
+
+#ifndef SnapByteHook
+#define SnapByteHook(i)         // Host stress tool: runs the writer between bytes
+#endif
+
+extern volatile unsigned char SnapSeq;
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void SnapPublish(void);
+
+void SnapRead(SpeedSnap * s);
+
+
+#endif	/* SNAPSHOT_H */
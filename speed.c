@@ -0,0 +1,260 @@
+/******************************************************************************/
+/* Files to Include                                                           */
+/******************************************************************************/
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stdint.h>         /* For uint8_t definition */
+#include <stdbool.h>        /* For true/false definition */
+#include "system.h"
+#include "timers.h"
+#include "hal.h"
+#include "globals.h"
+#include "speed.h"
+#include "observer.h"
+#include "protect.h"
+
+/******************************************************************************/
+/* Speed Estimator Variables                                                  */
+/******************************************************************************/
+
+unsigned char SpeedWinShift;        // Window in use: 2^SpeedWinShift ticks, SpeedWinLog2 at most
+
+static int SpeedRing[AxisCount][SpeedWinTicks]; // Counts in each of the last SpeedWinTicks ticks
+static unsigned char SpeedSlot[AxisCount]; // Oldest slot, overwritten next
+static long SpeedSum[AxisCount];    // Sum of SpeedRing
+
+static unsigned int SpeedT2Start; // SpeedClock at the start of the Timer2 period of the last call
+
+static unsigned int MTCount;    // Net channel A rising edges (+1 CW, -1 CCW)
+static unsigned int MTTime;     // Timer3 time of the last edge
+static unsigned int MTRefCount; // MTCount at the reference edge
+static unsigned int MTRefTime;  // Timer3 time of the reference edge
+static unsigned char MTIdle;    // Sample ticks since the last edge
+static unsigned char MTValid;   // Reference edge is valid
+static long MTLast;             // Last speed estimate (milli-rev/s)
+
+/******************************************************************************/
+/* Speed Estimator Functions                                                  */
+/******************************************************************************/
+
+/*******************************
+ * SpeedWindowInit(void)
+ *
+ * Empties the sliding window of every axis and takes the current positions
+ * as their start. The window is SpeedWinTicks long.
+ *******************************/
+void SpeedWindowInit(void)
+{
+    unsigned char a;
+    unsigned char i;
+
+    SpeedWinShift = SpeedWinLog2;
+    for (a = 0; a < AxisCount; a++)
+    {
+        for (i = 0; i < SpeedWinTicks; i++)
+        {
+            SpeedRing[a][i] = 0;
+        }
+        SpeedSlot[a] = 0;
+        SpeedSum[a] = 0;
+        EncoderLastPos[a] = EncoderPos[a];
+    }
+}
+
+/*******************************
+ * SpeedWindowResize(unsigned char shift)
+ *
+ * Called by the low priority ISR at a sample tick, before the window update,
+ * to make every window 2^shift ticks long (shift at most SpeedWinLog2). The
+ * slots in use are refilled with the mean counts per tick of the old window,
+ * so the speed carries on at the same value instead of restarting from 0.
+ * At most SpeedWinTicks slots per axis, no divisions.
+ *******************************/
+void SpeedWindowResize(unsigned char shift)
+{
+    unsigned char a;
+    unsigned char i;
+    int n;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        n = (int)(SpeedSum[a] >> SpeedWinShift);   // Mean counts per tick
+        for (i = 0; i < (unsigned char)(1 << shift); i++)
+        {
+            SpeedRing[a][i] = n;
+        }
+        SpeedSlot[a] = 0;
+        SpeedSum[a] = (long)n << shift;
+    }
+    SpeedWinShift = shift;
+}
+
+/*******************************
+ * SpeedWindowUpdate(unsigned char a)
+ *
+ * Called by the low priority ISR on every sample tick (25 ms) for each axis a
+ * once its EncoderPos is up to date, and returns its speed in milli-rev/s.
+ * The counts since the last tick replace the oldest slot of the ring and the
+ * running sum is corrected by the difference, so the cost is the same for
+ * any window length, and the divide by the window length is a shift. The speed is fresh
+ * every tick instead of once per window, with the same resolution as a
+ * fixed window of the same length. CHAcount is set to the window sum. A
+ * slot holds one tick of counts as an int (655 rev/s); the product with
+ * SpeedGainQ8 fits a long up to 8388/SpeedWinTicks rev/s (524 at 16 ticks).
+ *******************************/
+long SpeedWindowUpdate(unsigned char a)
+{
+    int n = FitInt(EncoderPos[a] - EncoderLastPos[a]);  // Counts this tick
+    unsigned char slot = SpeedSlot[a];
+
+    EncoderLastPos[a] = EncoderPos[a];
+    SpeedSum[a] += n - SpeedRing[a][slot];
+    SpeedRing[a][slot] = n;
+    SpeedSlot[a] = (slot + 1) & ((1 << SpeedWinShift) - 1);
+    CHAcount[a] = SpeedSum[a];
+    return FitLong(SpeedSum[a] * SpeedGainQ8) >> (8 + SpeedWinShift);
+}
+
+/*******************************
+ * SpeedT2Periods(void)
+ *
+ * Called by the low priority ISR in the Timer2 branch, returns the Timer2
+ * periods since the call before: 1, or more when high_isr held the branch
+ * off so long that the single TMR2IF merged several ticks. The start of the
+ * current period is SpeedClock less the Timer2 count, so the latency of
+ * either call does not matter. Gaps of more than one SpeedClock wrap (25 ms)
+ * read short. At most 26 passes, one per period past the first.
+ *******************************/
+unsigned char SpeedT2Periods(void)
+{
+    unsigned char t2 = HalTimer2();
+    unsigned int now = SpeedClock();
+    unsigned int d;
+    unsigned char n;
+
+    if (HalTimer2() < t2)
+    {
+        t2 = 0;                         // Timer2 matched between the reads: the period began about now
+    }
+    d = (unsigned int)t2 << 4;          // Cycles into this period (Timer2 and the clock are 16 bits, also on the host)
+    if (now < d)
+    {
+        now = (uint16_t)(now - SpeedClockSkip); // Back across the clock wrap
+    }
+    now = (uint16_t)(now - d);
+    d = (uint16_t)(now - SpeedT2Start);
+    if (now < SpeedT2Start)
+    {
+        d = (uint16_t)(d - SpeedClockSkip);
+    }
+    SpeedT2Start = now;
+    for (n = 1; d > (unsigned int)(ObsTickCycles + ObsTickCycles/2); n++)
+    {
+        d -= (unsigned int)ObsTickCycles;             // Rounded to whole periods
+    }
+    return n;
+}
+
+/*******************************
+ * SpeedMTInit(void)
+ *
+ * Clears the M/T estimator. The first edge after this only sets the reference.
+ *******************************/
+void SpeedMTInit(void)
+{
+    MTCount = 0;
+    MTRefCount = 0;
+    MTIdle = 0;
+    MTValid = 0;
+    MTLast = 0;
+}
+
+/*******************************
+ * ReadCapture(void)
+ *
+ * Called by the low priority ISR on every CCP2 capture (channel A rising edge
+ * on RC1). The edge time was latched by hardware, so interrupt latency does
+ * not affect it. Channel B (RB4) at the rising edge of A gives the direction:
+ * low is CW, as in the edge decoder (encoder.h). EncoderPos is kept in quadrature units. One axis
+ * only (SpeedMT needs AxisCount 1). Every edge takes one from the overspeed
+ * budget, whatever its direction, as in high_isr (protect.h); there is no
+ * high priority ISR to mask for ProtTrip in this mode.
+ *******************************/
+void ReadCapture(void)
+{
+    MTTime = HalCapture2();
+#if SpeedMode == SpeedMT
+    if (--ProtEdges[0] == 0)
+    {
+        ProtTrip(ProtAxis(0) | ProtOverspeed); // Edge budget of this tick used up
+    }
+#endif
+    if (HalEncoderB() == 0)
+    {
+        MTCount++;
+        EncoderPos[0] += 4;
+    }
+    else
+    {
+        MTCount--;
+        EncoderPos[0] -= 4;
+    }
+}
+
+/*******************************
+ * SpeedMTUpdate(void)
+ *
+ * Called by the low priority ISR on every sample tick (25 ms) and returns the
+ * speed in milli-rev/s. If edges arrived since the last reference edge the
+ * speed is the edge count M over the time T between the reference edge and
+ * the newest edge, both exact edge times from the capture. At high speed M
+ * is large and this is the pulse count over about one tick; at low speed M is
+ * 1 or 2 and it becomes a period measurement, so resolution stays high over
+ * the whole range without switching logic. If no edge arrived the speed can
+ * be at most one edge over the time since the last edge, so the estimate is
+ * limited to that bound, and after MTStallTicks it is 0.
+ *******************************/
+long SpeedMTUpdate(void)
+{
+    int dm = (int)(MTCount - MTRefCount);
+    unsigned int dt;
+    unsigned long mag;
+
+    if (dm == 0)                        // No edge this tick
+    {
+        if (MTValid == 0 || ++MTIdle >= MTStallTicks)
+        {
+            MTValid = 0;                // Stopped, or too slow to time
+            MTLast = 0;
+            return 0;
+        }
+        dt = (uint16_t)(ReadTimer3() - MTRefTime); // Time since the last edge (16 bit wrap)
+        if (dt != 0)
+        {
+            mag = MTGain / dt;
+            if (MTLast > (long)mag)
+            {
+                MTLast = (long)mag;
+            }
+            else if (MTLast < -(long)mag)
+            {
+                MTLast = -(long)mag;
+            }
+        }
+        return MTLast;
+    }
+
+    MTIdle = 0;
+    dt = (uint16_t)(MTTime - MTRefTime); // Time spanned by the dm edges (16 bit wrap)
+    MTRefCount = MTCount;
+    MTRefTime = MTTime;
+    if (MTValid == 0 || dt == 0)        // First edge after a stop: start timing
+    {
+        MTValid = 1;
+        return MTLast;
+    }
+
+    mag = ((unsigned long)(dm < 0 ? -dm : dm) * MTGain) / dt;
+    MTLast = (dm < 0) ? -(long)mag : (long)mag;
+    return MTLast;
+}
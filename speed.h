@@ -0,0 +1,106 @@
+/* 
+ * File:   speed.h
+ *
+ * Speed estimators fed from the encoder interrupts and run on the sample
+ * tick, and the timebase of that tick.
+ */
+
+#ifndef SPEED_H
+#define	SPEED_H
+
+// Sample tick. Timer1 (SpeedEdgeISR) or Timer3 (SpeedTimer1) counts the
+// instruction clock and CCP2 in compare mode resets it in hardware with the
+// special event trigger, so every period is exact whatever the interrupt
+// latency. SpeedMT needs CCP2 for capture, and two axes need it for the
+// second PWM; these keep Timer0, whose reload adds to the count instead of
+// overwriting it (only the few cycles of the read-modify-write are lost).
+#define SpeedTickMs 25          // Requested sample period (ms)
+#if (SYS_FREQ % 4000L) != 0
+#error "SYS_FREQ must give a whole number of instruction cycles per ms"
+#endif
+#define SpeedTickCycles ((SYS_FREQ/4000L)*SpeedTickMs) // Instruction cycles per tick
+#if SpeedTickCycles <= 65536L
+#define SpeedTickPrescale 1     // Timer1/3 prescale, the smallest that fits 16 bits
+#define SpeedTickCKPS 0         // ... as TxCKPS1:TxCKPS0
+#elif SpeedTickCycles <= 2*65536L
+#define SpeedTickPrescale 2
+#define SpeedTickCKPS 1
+#elif SpeedTickCycles <= 4*65536L
+#define SpeedTickPrescale 4
+#define SpeedTickCKPS 2
+#elif SpeedTickCycles <= 8*65536L
+#define SpeedTickPrescale 8
+#define SpeedTickCKPS 3
+#else
+#error "SpeedTickMs is too long for a 16 bit timer at 1:8"
+#endif
+#if (SpeedTickCycles % SpeedTickPrescale) != 0
+#error "SpeedTickMs is not a whole number of timer counts"
+#endif
+#define SpeedTickCompare (SpeedTickCycles/SpeedTickPrescale - 1) // CCPR2: the timer counts 0..compare
+#define SpeedT0Reload (65535 - SpeedTickCompare) // Timer0 counts from here to the overflow
+#define SpeedTickTimer0 (SpeedMode == SpeedMT || AxisCount > 1) // CCP2 is taken, tick on Timer0
+
+// Timer counts since the last sample tick
+#if SpeedTickTimer0
+#define SpeedTickNow()      ReadTimer0()
+#elif SpeedMode == SpeedEdgeISR
+#define SpeedTickNow()      ReadTimer1()
+#else
+#define SpeedTickNow()      ReadTimer3()
+#endif
+
+// Clock that times the Timer2 ticks (SpeedT2Periods), in instruction cycles:
+// the sample tick timer, which the special event resets every SpeedTickCycles,
+// or with the Timer0 tick Timer3, free running at 1:1 over 16 bits.
+// SpeedClockSkip is the counts the 16 bit wrap skips.
+#if SpeedTickTimer0
+#define SpeedClock()        ReadTimer3()
+#define SpeedClockSkip 0
+#else
+#define SpeedClock()        SpeedTickNow()
+#define SpeedClockSkip (65535 - SpeedTickCompare)
+#if SpeedTickPrescale != 1
+#error "SpeedT2Periods needs the sample tick timer at 1:1"
+#endif
+#endif
+
+// Sliding window, one per axis: one slot of counts per sample tick, the speed
+// over the last 2^SpeedWinShift ticks comes out on every tick. SpeedWinLog2
+// sizes the ring and is the length at start up; a command can shorten it.
+#ifndef SpeedWinLog2
+#define SpeedWinLog2 4          // Window of up to 2^SpeedWinLog2 ticks (4: 16 x 25 ms = 400 ms)
+#endif
+#define SpeedWinTicks (1 << SpeedWinLog2)
+#define SpeedGainQ8 ((RPSScale*256L*1000L)/((long)EncoderCPR*SpeedTickMs)) // Counts per tick to milli-rev/s, Q8
+#if SpeedWinLog2 < 0 || SpeedWinLog2 > 5
+#error "SpeedWinLog2 must be 0..5 (window sum times SpeedGainQ8 must fit a long above 260 rev/s)"
+#endif
+
+// M/T method (SpeedMode == SpeedMT): CCP2 captures Timer3 on each channel A edge
+#define MTTimerHz (SYS_FREQ/32) // Timer3 at Fosc/4 with 1:8 prescaler (312.5 kHz, wraps in 209 ms)
+#define MTGain (RPSScale*MTTimerHz/EncoderLines) // edges*MTGain/Timer3 ticks = milli-rev/s
+#define MTStallTicks 7          // Sample ticks without an edge before speed is 0 (keeps spans < Timer3 wrap)
+
+extern unsigned char SpeedWinShift;
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void SpeedWindowInit(void);
+
+void SpeedWindowResize(unsigned char shift);
+
+long SpeedWindowUpdate(unsigned char a);
+
+unsigned char SpeedT2Periods(void);
+
+void SpeedMTInit(void);
+
+void ReadCapture(void);
+
+long SpeedMTUpdate(void);
+
+
+#endif	/* SPEED_H */
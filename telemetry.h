@@ -0,0 +1,66 @@
+/*
+ * File:   telemetry.h
+ *
+ * Binary telemetry stream on the USART (RC6/TX). Samples are framed into a
+ * ring buffer by a main loop task and sent by the TX interrupt, so nothing
+ * waits on the UART. The frame layout is shared with the
+ * host decoder (tools/tlmdecode.c), so this header has no SFR dependencies.
+ *
+ * Frame, multi-byte fields little endian, axis 0 only:
+ *   0      TlmSyncByte
+ *   1      sequence number (counts dropped frames too)
+ *   2..3   time, Timer2 ticks (ms) of the snapshot
+ *   4..7   EncoderPos (quadrature counts)
+ *   8..11  RPS (milli-rev/s)
+ *   12..13 Duty (0..DutyMax)
+ *   14     CRC-8 (poly 0x07, init 0) over bytes 1..13
+ *
+ * Block frame, raw data sent on request (e.g. the EEPROM log dump):
+ *   0      TlmBlockSync
+ *   1      block number
+ *   2..17  TlmBlockData bytes
+ *   18     CRC-8 over bytes 1..17
+ *
+ * Reply frame, one per command received (see command.h):
+ *   0      TlmReplySync
+ *   1      command code, as received
+ *   2      axis, as received
+ *   3      status (CmdOk or the reason the command was refused)
+ *   4..7   value of the parameter after the command
+ *   8      CRC-8 over bytes 1..7
+ */
+
+#ifndef TELEMETRY_H
+#define	TELEMETRY_H
+
+#define TlmSyncByte 0xA5
+#define TlmFrameLen 15
+#define TlmBlockSync 0x5A
+#define TlmBlockData 16
+#define TlmBlockLen (TlmBlockData+3)
+#define TlmReplySync 0x3C
+#define TlmReplyLen 9
+#define TlmBufSize 64           // Ring buffer bytes, power of two
+#define TlmDecim 10             // Scheduler ticks per sample (100 Hz)
+#define TlmBaud 57600           // 8N1, BRGH = 1
+#define TlmSPBRG (((SYS_FREQ/8/TlmBaud)+1)/2-1) // Rounded: 10 gives 56818 baud at 10 MHz (-1.4%)
+
+extern unsigned int TlmDrops;   // Frames dropped because the ring was full
+extern const unsigned char TlmCrcTable[256]; // CRC-8, poly 0x07, also checks commands
+
+/*----------------------------------------------------------------------------*/
+/*Function Prototypes*/
+/*----------------------------------------------------------------------------*/
+
+void TlmInit(void);
+
+void TlmSample(void);
+
+unsigned char TlmBlock(unsigned char id, const unsigned char * data);
+
+unsigned char TlmReply(unsigned char code, unsigned char axis, unsigned char status, long value);
+
+void TlmTx(void);
+
+
+#endif	/* TELEMETRY_H */
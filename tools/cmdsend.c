@@ -0,0 +1,108 @@
+/*
+ * File:   cmdsend.c
+ *
+ * Encodes one command frame (see command.h) for the firmware's USART
+ * receiver. With a value the parameter is set, without one it is read. The
+ * frame goes to stdout as binary, for a serial port, or with -t as a line of
+ * the simulator's receive script (sim/pracsim -c) sent at that time. The
+ * reply comes back in the telemetry stream; tools/tlmdecode prints it.
+ *
+ * Build: make -C tools cmdsend
+ * Use:   tools/cmdsend speed 0 2500 > /dev/ttyUSB0   (port set to 57600 8N1)
+ *        tools/cmdsend -t 1.5 kp 0 8 >> script.txt; sim/pracsim -c script.txt
+ * Parameters: speed rps duty kp ki window stats fault cal capture
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../command.h"
+
+static const char * const Names[] = {"", "speed", "rps", "duty", "kp", "ki", "window", "stats", "fault", "cal", "capture"};
+
+/*******************************
+ * Crc8: CRC-8, polynomial 0x07, bitwise (the firmware uses a table)
+ *******************************/
+static unsigned char Crc8(const unsigned char * p, int n)
+{
+    unsigned char crc = 0;
+    int i;
+
+    while (n-- > 0)
+    {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void Usage(const char * prog)
+{
+    fprintf(stderr, "usage: %s [-t seconds] speed|rps|duty|kp|ki|window|stats|fault|cal|capture axis [value]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned char f[CmdFrameLen];
+    unsigned long v = 0;
+    double t = -1.0;
+    int code = 0;
+    int c;
+    int i;
+
+    while ((c = getopt(argc, argv, "t:")) != -1)
+    {
+        if (c != 't')
+        {
+            Usage(argv[0]);
+        }
+        t = atof(optarg);
+    }
+    if (argc - optind < 2 || argc - optind > 3)
+    {
+        Usage(argv[0]);
+    }
+    for (i = 1; i < (int)(sizeof Names / sizeof Names[0]); i++)
+    {
+        if (strcmp(argv[optind], Names[i]) == 0)
+        {
+            code = i;
+        }
+    }
+    if (code == 0)
+    {
+        Usage(argv[0]);
+    }
+    if (argc - optind == 3)
+    {
+        code |= CmdSet;
+        v = (unsigned long)strtol(argv[optind+2], NULL, 0);
+    }
+
+    f[0] = CmdSync;
+    f[1] = (unsigned char)code;
+    f[2] = (unsigned char)atoi(argv[optind+1]);
+    for (i = 0; i < 4; i++)
+    {
+        f[3+i] = (unsigned char)(v >> (8*i));
+    }
+    f[7] = Crc8(f+1, CmdFrameLen-2);
+
+    if (t < 0)
+    {
+        fwrite(f, 1, sizeof f, stdout);
+        return EXIT_SUCCESS;
+    }
+    printf("%g", t);
+    for (i = 0; i < CmdFrameLen; i++)
+    {
+        printf(" %02x", f[i]);
+    }
+    printf("\n");
+    return EXIT_SUCCESS;
+}
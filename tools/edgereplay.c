@@ -0,0 +1,481 @@
+/*
+ * File:   edgereplay.c
+ *
+ * Rebuilds a raw edge capture (see capture.h) from the block frames of a
+ * telemetry stream and replays it offline through the firmware's own decoder
+ * (encoder.h, the same macros high_isr expands), to tell a decode fault from
+ * a signal fault and to try decoder variants on real edges. Prints one CSV
+ * line per record on stdout: record, time in us from the trigger record, ms
+ * field, the pins, what the RB change decoder made of the interrupt on each
+ * axis and the position it reaches. Then, on stderr, the counts each variant
+ * gives over the whole trace and its host time per record:
+ *
+ *   edge     EncLatch + EncDecode, high_isr with the RB change input
+ *   qem      QEM table lookup per axis (the decoder high_isr replaced)
+ *   sampled  EncFilter + EncDecode every EncSampleCycles over the pin levels
+ *            the records give (EncoderSampled, EncFilterN), as if the same
+ *            signal had gone to the sampled input
+ *
+ * The protection budgets are refilled on the trace time as ProtTick does
+ * (ProtEdgesMs per ms up to ProtEdgesCap, ProtIllegalMax every ProtWindowMs),
+ * so each variant also tells whether it would have cut the PWM. A gap of 15
+ * ms or more (ms field 15) may hide whole Timer3 wraps and is taken as the
+ * shortest it can be; its time is marked with '+'. Where in its window the
+ * firmware's refill stood at the first record is not in the dump, so the
+ * replay starts with full budgets and may trip a window later than it did.
+ *
+ * Build: make -C tools edgereplay
+ * Other filters: make -C tools -B edgereplay CFLAGS="-O2 -Wall -I.. -DEncFilterN=3"
+ * Use:   tools/edgereplay capture.bin > edges.csv
+ *        tools/edgereplay -n 10000 capture.bin > /dev/null   (longer benchmark)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../system.h"
+#include "../globals.h"
+#include "../telemetry.h"
+#include "../capture.h"
+
+#define HalPWMOff()                 // Only ProtFault is kept here
+#define HalEdgeIntOff()             // ... and the trace has every edge
+#include "../protect.h"
+#include "../encoder.h"
+
+#define CyclesMs (SYS_FREQ/4000L)   // Instruction cycles (Timer3 counts) per ms
+
+// The decoder state, as the firmware declares it
+unsigned char EncoderState;
+volatile unsigned char EdgeUp[AxisCount];
+volatile unsigned char EdgeDown[AxisCount];
+volatile unsigned char EdgeIllegal[AxisCount];
+volatile unsigned char EdgeNone;
+unsigned char EdgeDiff;
+unsigned char EncFilt;
+unsigned char EncCnt0;
+unsigned char EncCnt1;
+unsigned char EncCnt2;
+
+// The table decoder the firmware had before encoder.h, for the qem variant
+#define QEMIllegal 2                // Entry for an illegal transition (both channels changed)
+static const signed char QEM[16] = {0,-1,1,2,1,0,2,-1,-1,2,0,1,2,1,-1,0}; // Step per old*4+new state
+
+volatile unsigned char ProtFault;
+volatile unsigned char ProtEdges[AxisCount];
+volatile unsigned char ProtIllegal[AxisCount];
+
+static unsigned char Block[CapBlocks+1][TlmBlockData];
+static int Have[CapBlocks+1];
+
+static int Records;                 // Records in the capture
+static int TrigAt;                  // The trigger record
+static int Axes;                    // AxisCount of the firmware
+static unsigned char Pins[CapRecords];
+static long long Time[CapRecords];  // Instruction cycles from the first record
+static unsigned char Ms[CapRecords]; // Timer2 ticks since the record before, 15 for 15 or more
+
+typedef struct
+{
+    long Up[AxisCount];
+    long Down[AxisCount];
+    long Illegal[AxisCount];
+    long None;
+    unsigned char Fault;            // ProtFault latched by the replay
+    int FaultAt;                    // ... at this record
+} Counts;
+
+/*******************************
+ * Crc8: CRC-8, polynomial 0x07, bitwise (the firmware uses a table)
+ *******************************/
+static unsigned char Crc8(const unsigned char * p, int n)
+{
+    unsigned char crc = 0;
+    int i;
+
+    while (n-- > 0)
+    {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*******************************
+ * ReadCapture: keeps the last good block frame of each capture block. A new
+ * header starts a new dump, so blocks of an older one are dropped.
+ *******************************/
+static void ReadCapture(FILE * in)
+{
+    unsigned char f[TlmBlockLen];
+    int n = 0;
+    int c;
+    int i;
+    int b;
+
+    while ((c = getc(in)) != EOF)
+    {
+        f[n++] = (unsigned char)c;
+        if (f[0] != TlmBlockSync)
+        {
+            n = 0;
+            continue;
+        }
+        if (n < TlmBlockLen)
+        {
+            continue;
+        }
+        b = f[1] - CapBlockId;
+        if (Crc8(f+1, TlmBlockLen-2) != f[TlmBlockLen-1] || b < 0 || b > CapBlocks)
+        {
+            for (i = 1; i < n && f[i] != TlmBlockSync; i++)
+            {
+                ;                           // Resync on the next sync byte
+            }
+            n -= i;
+            memmove(f, f+i, (size_t)n);
+            continue;
+        }
+        if (b == 0)
+        {
+            memset(Have, 0, sizeof Have);
+        }
+        memcpy(Block[b], f+2, TlmBlockData);
+        Have[b] = 1;
+        n = 0;
+    }
+}
+
+/*******************************
+ * Rebuild: records from the blocks, Timer3 unwrapped into Time
+ *******************************/
+static int Rebuild(void)
+{
+    const unsigned char * d;
+    unsigned int t;
+    unsigned int last = 0;
+    long long gap;
+    int b;
+    int i;
+
+    for (b = 0; b <= CapBlocks; b++)
+    {
+        if (!Have[b])
+        {
+            fprintf(stderr, "capture block %d missing\n", b);
+            return 0;
+        }
+    }
+    Records = Block[0][1];
+    TrigAt = Block[0][2];
+    Axes = Block[0][3];
+    if (Records < 1 || Records > CapRecords || TrigAt >= Records || Axes < 1 || Axes > AxisCount)
+    {
+        fprintf(stderr, "bad capture header\n");
+        return 0;
+    }
+    for (i = 0; i < Records; i++)
+    {
+        d = &Block[1][0] + i * CapRecordLen; // Blocks are consecutive in Block[]
+        t = d[0] | (unsigned int)d[1] << 8;
+        Pins[i] = d[2] & 0x0F;
+        Ms[i] = d[2] >> 4;
+        gap = (unsigned int)(t - last) & 0xFFFF;
+        if (i > 0 && Ms[i] == 15 && gap < 14 * CyclesMs)
+        {
+            gap += 65536;                   // At least one wrap
+        }
+        Time[i] = (i == 0) ? 0 : Time[i-1] + gap;
+        last = t;
+    }
+    return 1;
+}
+
+/*******************************
+ * Start: decoder and budgets as after a reset, on the pins of record 0
+ *******************************/
+static void Start(void)
+{
+    int a;
+
+    EncoderState = Pins[0];
+    EncFilt = Pins[0];
+    EncCnt0 = 0;
+    EncCnt1 = 0;
+    EncCnt2 = 0;
+    EdgeNone = 0;
+    ProtFault = 0;
+    for (a = 0; a < AxisCount; a++)
+    {
+        EdgeUp[a] = 0;
+        EdgeDown[a] = 0;
+        EdgeIllegal[a] = 0;
+        ProtEdges[a] = ProtEdgesCap;
+        ProtIllegal[a] = ProtIllegalMax;
+    }
+}
+
+/*******************************
+ * Refill: the ProtTick budget refills for the ms ticks from t0 to t1
+ *******************************/
+static void Refill(long long t0, long long t1)
+{
+    long long ms;
+    int a;
+
+    for (ms = t0 / CyclesMs + 1; ms <= t1 / CyclesMs; ms++)
+    {
+        for (a = 0; a < AxisCount; a++)
+        {
+            ProtEdges[a] = (ProtEdges[a] + ProtEdgesMs > ProtEdgesCap) ? ProtEdgesCap : ProtEdges[a] + ProtEdgesMs;
+            if (ms % ProtWindowMs == 0)
+            {
+                ProtIllegal[a] = ProtIllegalMax;
+            }
+        }
+    }
+}
+
+/*******************************
+ * Tally: the byte counters of the firmware decoder into c, as ReadEncoder
+ * folds them, and a fault that has just latched
+ *******************************/
+static void Tally(Counts * c, int r)
+{
+    int a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        c->Up[a] += EdgeUp[a];
+        c->Down[a] += EdgeDown[a];
+        c->Illegal[a] += EdgeIllegal[a];
+        EdgeUp[a] = 0;
+        EdgeDown[a] = 0;
+        EdgeIllegal[a] = 0;
+    }
+    c->None += EdgeNone;
+    EdgeNone = 0;
+    if (ProtFault != 0 && c->Fault == 0)
+    {
+        c->Fault = ProtFault;
+        c->FaultAt = r;
+    }
+}
+
+/*******************************
+ * ReplayEdge: one RB change interrupt per record. With out, the CSV line of
+ * each record.
+ *******************************/
+static void ReplayEdge(Counts * c, FILE * out)
+{
+    static const char * const what[] = {"-", "up", "down", "illegal"};
+    long pos[AxisCount] = {0};
+    int ev[AxisCount];
+    int r;
+    int a;
+
+    memset(c, 0, sizeof *c);
+    Start();
+    for (r = 1; r < Records; r++)
+    {
+        Refill(Time[r-1], Time[r]);
+        EncLatch(Pins[r]);
+        EncDecode();
+        for (a = 0; a < AxisCount; a++)
+        {
+            ev[a] = EdgeIllegal[a] ? 3 : EdgeDown[a] ? 2 : EdgeUp[a] ? 1 : 0;
+            pos[a] += (long)EdgeUp[a] - EdgeDown[a];
+        }
+        if (out != NULL)
+        {
+            fprintf(out, "%d,%s%.1f,%d,%d,%d", r - TrigAt, Ms[r] == 15 ? "+" : "",
+                    (double)(Time[r] - Time[TrigAt]) * 4e6 / SYS_FREQ, Ms[r],
+                    (Pins[r] >> 1) & 1, Pins[r] & 1);
+            if (Axes > 1)
+            {
+                fprintf(out, ",%d,%d", (Pins[r] >> 3) & 1, (Pins[r] >> 2) & 1);
+            }
+            for (a = 0; a < Axes; a++)
+            {
+                fprintf(out, ",%s,%ld", EdgeNone ? "none" : what[ev[a]], pos[a]);
+            }
+            fprintf(out, "\n");
+        }
+        Tally(c, r);
+    }
+}
+
+/*******************************
+ * ReplayQEM: the table decoder, one lookup per axis per record
+ *******************************/
+static void ReplayQEM(Counts * c)
+{
+    unsigned char old = Pins[0];
+    signed char s;
+    int r;
+    int a;
+
+    memset(c, 0, sizeof *c);
+    for (r = 1; r < Records; r++)
+    {
+        for (a = 0; a < AxisCount; a++)
+        {
+            s = QEM[((old >> (2*a)) & 3) << 2 | ((Pins[r] >> (2*a)) & 3)];
+            if (s == QEMIllegal)
+            {
+                c->Illegal[a]++;
+            }
+            else if (s > 0)
+            {
+                c->Up[a]++;
+            }
+            else if (s < 0)
+            {
+                c->Down[a]++;
+            }
+        }
+        c->None += (Pins[r] == old);
+        old = Pins[r];
+    }
+}
+
+/*******************************
+ * ReplaySampled: the glitch filter every EncSampleCycles, on the level each
+ * record left the pins at
+ *******************************/
+static void ReplaySampled(Counts * c)
+{
+    long long t;
+    long long last = 0;
+    int r = 0;
+
+    memset(c, 0, sizeof *c);
+    Start();
+    for (t = EncSampleCycles; t <= Time[Records-1] + EncFilterN * EncSampleCycles; t += EncSampleCycles)
+    {
+        while (r + 1 < Records && Time[r+1] <= t)
+        {
+            r++;
+        }
+        Refill(last, t);
+        last = t;
+        EncFilter(Pins[r]);
+        EncDecode();
+        Tally(c, r);
+    }
+}
+
+/*******************************
+ * Report: one variant's counts and its host time per record
+ *******************************/
+static void Report(const char * name, const Counts * c, double ns)
+{
+    int a;
+
+    fprintf(stderr, "%-8s", name);
+    for (a = 0; a < Axes; a++)
+    {
+        fprintf(stderr, "  axis %d: %5ld up %5ld down %3ld illegal, net %+6ld", a,
+                c->Up[a], c->Down[a], c->Illegal[a], c->Up[a] - c->Down[a]);
+    }
+    fprintf(stderr, ", %3ld empty", c->None);
+    if (c->Fault != 0)
+    {
+        fprintf(stderr, ", fault 0x%02X at %d", c->Fault, c->FaultAt - TrigAt);
+    }
+    fprintf(stderr, ", %.1f ns/record\n", ns);
+}
+
+static void Usage(const char * prog)
+{
+    fprintf(stderr, "usage: %s [-n repeats] [capture.bin]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char * argv[])
+{
+    static const char * const trig[] = {"illegal", "empty", "fault"};
+    FILE * in = stdin;
+    Counts c;
+    clock_t t0;
+    double per;
+    long n = 1000;
+    long k;
+    int v;
+    int i;
+
+    while ((v = getopt(argc, argv, "n:")) != -1)
+    {
+        if (v != 'n' || (n = atol(optarg)) < 1)
+        {
+            Usage(argv[0]);
+        }
+    }
+    if (argc - optind > 1)
+    {
+        Usage(argv[0]);
+    }
+    if (argc - optind == 1 && (in = fopen(argv[optind], "rb")) == NULL)
+    {
+        perror(argv[optind]);
+        return EXIT_FAILURE;
+    }
+    ReadCapture(in);
+    if (!Have[0])
+    {
+        fprintf(stderr, "no edge capture in the stream\n");
+        return EXIT_FAILURE;
+    }
+    if (!Rebuild())
+    {
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "%d records over %.3f ms, trigger", Records, (double)Time[Records-1] * 4e3 / SYS_FREQ);
+    if (Block[0][0] & CapTrigNow)
+    {
+        fprintf(stderr, " command");
+    }
+    for (i = 0; i < 3; i++)
+    {
+        if (Block[0][0] & (1 << i))
+        {
+            fprintf(stderr, " %s", trig[i]);
+        }
+    }
+    fprintf(stderr, " at record %d\n", TrigAt);
+
+    printf("record,time_us,ms,a0,b0%s", Axes > 1 ? ",a1,b1" : "");
+    for (i = 0; i < Axes; i++)
+    {
+        printf(",edge%d,pos%d", i, i);
+    }
+    printf("\n");
+    ReplayEdge(&c, stdout);
+
+    per = (double)n * (Records - 1) / 1e9;
+    t0 = clock();
+    for (k = 0; k < n; k++)
+    {
+        ReplayEdge(&c, NULL);
+    }
+    Report("edge", &c, (double)(clock() - t0) / CLOCKS_PER_SEC / per);
+    t0 = clock();
+    for (k = 0; k < n; k++)
+    {
+        ReplayQEM(&c);
+    }
+    Report("qem", &c, (double)(clock() - t0) / CLOCKS_PER_SEC / per);
+    t0 = clock();
+    for (k = 0; k < n; k++)
+    {
+        ReplaySampled(&c);
+    }
+    Report("sampled", &c, (double)(clock() - t0) / CLOCKS_PER_SEC / per);
+    return EXIT_SUCCESS;
+}
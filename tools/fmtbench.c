@@ -0,0 +1,172 @@
+/* 
+ * File:   fmtbench.c
+ *
+ * Host-side comparison of FormatFixed against the old WriteLCD sprintf
+ * ("%*.*g" on a double). Runs both over a sweep of milli-RPS values, reports
+ * how many fields differ and why, shows a few samples and times each
+ * formatter. FormatFixed differs from sprintf on purpose in three ways:
+ *
+ *   zeros     it keeps the trailing zeros of the decimals it shows, where %g
+ *             drops them ("1.500" for "  1.5", "0.000" for "    0")
+ *   negative  -9.995 to -99.999: %g's four significant digits take six
+ *             characters and sprintf overflowed ("-12.!"); FormatFixed
+ *             drops decimals to fit ("-12.3", "-100")
+ *   ties      a value exactly half way between two shown ones is rounded
+ *             away from zero; as a double it is mostly a little under half
+ *             way, and sprintf rounded it down ("10.05" for 10.045)
+ *   overflow  a value that does not fit at all fills the field with the
+ *             marker ("!!!!!"), where sprintf kept four characters of its
+ *             exponent form ("1.23!" for 123456.789)
+ *
+ * Any other difference is counted as such and fails the run.
+ *
+ * On the PIC18F452 (XC8 1.33, funclist of the sprintf build) the old path
+ * linked _sprintf (5328 bytes) plus _scale, _fround, __div_to_l_,
+ * __tdiv_to_l_ and the ___ll* helpers. The host object sizes printed by
+ * "make fmtbench-size" give the relative size of the two formatters.
+ *
+ * Build: make -C tools fmtbench && tools/fmtbench
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../format.h"
+
+#define Width 5
+#define Digits 3
+#define Scale 1000.0
+#define Lo (-99999L)
+#define Hi 999999L
+#define Reps 20
+
+/*******************************
+ * Zeros: a and b are the same number once a's trailing zeros (and a bare
+ * '.') are dropped, alignment aside
+ *******************************/
+static int Zeros(const char * a, const char * b)
+{
+    char t[32];
+    size_t n;
+
+    strcpy(t, a);
+    n = strlen(t);
+    if (strchr(t, '.') != NULL)
+    {
+        while (t[n-1] == '0')
+        {
+            t[--n] = '\0';
+        }
+        if (t[n-1] == '.')
+        {
+            t[--n] = '\0';
+        }
+    }
+    return strcmp(t + strspn(t, " "), b + strspn(b, " ")) == 0;
+}
+
+/*******************************
+ * OldWriteLCD: the sprintf formatting from the previous WriteLCD
+ *******************************/
+static void OldWriteLCD(char * buf, double var)
+{
+    int width = sprintf(buf, "%*.*g", Width, Width-1, var);
+    if (width > Width)
+    {
+        buf[Width-1] = '!';
+        buf[Width] = '\0';
+    }
+}
+
+static double Seconds(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    char a[32];
+    char b[32];
+    char c[32];
+    long v;
+    long zeros = 0;
+    long negative = 0;
+    long ties = 0;
+    long overflow = 0;
+    long other = 0;
+    long total = 0;
+    int rep;
+    unsigned sink = 0;
+    clock_t start;
+    double tnew;
+    double told;
+    static const long samples[] = {0, 5, 1500, -1500, 12345, 99996, 123456789};
+    unsigned i;
+
+    for (v = Lo; v <= Hi; v++)
+    {
+        FormatFixed(a, v, Digits, Width, Digits, '!');
+        OldWriteLCD(b, v/Scale);
+        total++;
+        if (strcmp(a, b) == 0)
+        {
+            continue;
+        }
+        if (a[0] == '!')
+        {
+            overflow++;
+        }
+        else if (b[Width-1] == '!')
+        {
+            negative++;
+        }
+        else if (Zeros(a, b))
+        {
+            zeros++;
+        }
+        else
+        {
+            OldWriteLCD(c, (v + (v < 0 ? -0.01 : 0.01))/Scale);
+            if (Zeros(a, c))
+            {
+                ties++;                 // A hundredth off the tie, sprintf agrees
+            }
+            else if (++other <= 5)
+            {
+                printf("other: %ld [%s] [%s]\n", v, a, b);
+            }
+        }
+    }
+
+    printf("%-12s %-8s %-8s\n", "milli", "new", "sprintf");
+    for (i = 0; i < sizeof samples/sizeof samples[0]; i++)
+    {
+        FormatFixed(a, samples[i], Digits, Width, Digits, '!');
+        OldWriteLCD(b, samples[i]/Scale);
+        printf("%-12ld [%s]  [%s]\n", samples[i], a, b);
+    }
+    printf("%ld of %ld fields differ: zeros %ld, negative %ld, ties %ld, overflow %ld, other %ld\n",
+           zeros + negative + ties + overflow + other, total, zeros, negative, ties, overflow, other);
+
+    start = clock();
+    for (rep = 0; rep < Reps; rep++)
+        for (v = Lo; v <= Hi; v++)
+        {
+            FormatFixed(a, v, Digits, Width, Digits, '!');
+            sink += (unsigned char)a[Width-1];
+        }
+    tnew = Seconds(start);
+
+    start = clock();
+    for (rep = 0; rep < Reps; rep++)
+        for (v = Lo; v <= Hi; v++)
+        {
+            OldWriteLCD(b, v/Scale);
+            sink += (unsigned char)b[Width-1];
+        }
+    told = Seconds(start);
+
+    printf("FormatFixed %.1f ns/call, sprintf %.1f ns/call, %.1fx (%u)\n",
+           1e9*tnew/(Reps*total), 1e9*told/(Reps*total), told/tnew, sink & 1);
+    return other == 0 ? 0 : 1;
+}
@@ -0,0 +1,1236 @@
+/*
+ * File:   isrcheck.c
+ *
+ * Static worst case hardware stack depth and interrupt cycle bounds from the
+ * XC8 assembler listing, run after every build (see .build-post in the
+ * project Makefile). The call graph is built from the code itself, so the
+ * library routines an ISR reaches (___lmul, ___aldiv, i1___ftdiv ...) are
+ * counted like any other function. Reported:
+ *
+ *   stack   return addresses pushed by main at its deepest, plus each ISR
+ *           (its entry and its deepest call chain), against the 31 level
+ *           hardware stack. The compiler's own figure is shown next to it.
+ *   cycles  longest path through each ISR in instruction cycles, interrupt
+ *           latency and the context save and restore included
+ *
+ * Cycles per instruction are those of the PIC18 data sheet: branches, calls,
+ * returns, movff, lfsr and table reads take 2, a taken conditional branch 2,
+ * a taken skip 2 (3 over a two word instruction). A loop costs its longest
+ * pass times its bound, plus one more pass. Counted loops (movlw N, movwf x,
+ * ..., decfsz x) are bounded from the code; every other loop needs a line in
+ * the bounds file. A computed jump (a write to PCL or TOS) is taken as a call
+ * to any of the functions the compiler lists as called by that function but
+ * not called directly, which covers calls through function pointers.
+ *
+ * The .sym file and funclist are optional: they resolve call targets that
+ * have no label in the listing and show which functions the listing lacks.
+ * The exit status is 1 if a budget is exceeded or a bound could not be found.
+ *
+ * Build: make -C tools isrcheck
+ * Use:   tools/isrcheck [-b bounds] [-s levels] [-h cycles] [-l cycles]
+ *            listing.lst [file.sym] [funclist]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MaxName 64
+#define MaxArg 96
+#define MaxDecl 2000                // Declared callees, all functions
+#define MaxBounds 200
+#define IntLatency 4                // Cycles from the flag to the first ISR instruction (3 or 4)
+#define StackLevels 31              // PIC18 hardware return stack
+
+enum { KPlain, KSkip, KCond, KJump, KCall, KRet, KInd };
+
+typedef struct
+{
+    unsigned long Addr;             // Byte address
+    int Words;                      // Program words (1 or 2)
+    unsigned Op0;                   // Opcode words
+    unsigned Op1;
+    int Line;                       // Listing line
+    int Func;                       // Function whose header precedes it
+    int Kind;
+    int Cycles;                     // Cycles when not branching
+    int Target;                     // Code index of the branch or call target, -1 if none
+    char Op[8];
+    char Arg[MaxArg];
+} Insn;
+
+typedef struct
+{
+    char Name[MaxName];
+    unsigned long Addr;
+    int Next;                       // Code lines read before it, to tell code labels from data
+    int IsCode;                     // Labels an instruction
+} Label;
+
+typedef struct
+{
+    char Name[MaxName];
+    int Level;                      // Interrupt level, 0 if not an ISR
+    int Required;                   // Compiler's stack levels required when called, -1 if none
+    int At;                         // Code index of its label, -1 if not in the listing
+} Func;
+
+typedef struct
+{
+    int State;                      // 0 new, 1 being worked out, 2 done
+    int Bad;                        // No bound (reported)
+    long Value;
+} Memo;
+
+static Insn * Code;
+static int NCode;
+static Label * Labels;
+static int NLabels;
+static Func * Funcs;
+static int NFuncs;
+static char DeclName[MaxDecl][MaxName];
+static int DeclOf[MaxDecl];
+static int NDecl;
+static char BoundName[MaxBounds][MaxName];
+static long BoundIter[MaxBounds];
+static int NBounds;
+static Memo * CycleMemo;
+static Memo * DepthMemo;
+
+static void * Grow(void * p, int n, size_t size)
+{
+    if ((n & (n - 1)) == 0)         // Double at every power of two
+    {
+        p = realloc(p, (n ? 2 * n : 1) * size);
+        if (p == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return p;
+}
+
+static void Copy(char * dst, const char * src, size_t n, size_t size)
+{
+    if (n >= size)
+    {
+        n = size - 1;
+    }
+    memcpy(dst, src, n);
+    dst[n] = 0;
+}
+
+/*******************************
+ * Operand: the symbol of the n-th operand of i, without the "& (0+255)"
+ * bank mask and the access bits, for comparing loop counters.
+ *******************************/
+static void Operand(const Insn * i, int n, char * out)
+{
+    const char * p = i->Arg;
+    size_t k;
+
+    while (n-- > 0 && (p = strchr(p, ',')) != NULL)
+    {
+        p++;
+    }
+    if (p == NULL)
+    {
+        out[0] = 0;
+        return;
+    }
+    while (isspace((unsigned char)*p))
+    {
+        p++;
+    }
+    k = strcspn(p, ",&; \t");
+    Copy(out, p, k, MaxArg);
+}
+
+static int IsPC(const char * s)
+{
+    return strcmp(s, "pcl") == 0 || strcmp(s, "4089") == 0 ||
+        strcmp(s, "tosl") == 0 || strcmp(s, "4093") == 0 ||
+        strcmp(s, "tosh") == 0 || strcmp(s, "4094") == 0 ||
+        strcmp(s, "tosu") == 0 || strcmp(s, "4095") == 0;
+}
+
+/*******************************
+ * Classify: kind and base cycles of an instruction from its mnemonic
+ *******************************/
+static void Classify(Insn * i)
+{
+    static const char * skips[] = {"btfsc", "btfss", "decfsz", "incfsz", "dcfsnz", "infsnz",
+        "cpfseq", "cpfsgt", "cpfslt", "tstfsz"};
+    static const char * conds[] = {"bc", "bnc", "bz", "bnz", "bn", "bnn", "bov", "bnov"};
+    char a0[MaxArg];
+    char a1[MaxArg];
+    unsigned k;
+
+    i->Kind = KPlain;
+    i->Cycles = 1;
+    for (k = 0; k < sizeof(skips)/sizeof(skips[0]); k++)
+    {
+        if (strcmp(i->Op, skips[k]) == 0)
+        {
+            i->Kind = KSkip;
+        }
+    }
+    for (k = 0; k < sizeof(conds)/sizeof(conds[0]); k++)
+    {
+        if (strcmp(i->Op, conds[k]) == 0)
+        {
+            i->Kind = KCond;
+        }
+    }
+    if (strcmp(i->Op, "goto") == 0 || strcmp(i->Op, "bra") == 0)
+    {
+        i->Kind = KJump;
+        i->Cycles = 2;
+    }
+    else if (strcmp(i->Op, "call") == 0 || strcmp(i->Op, "rcall") == 0)
+    {
+        i->Kind = KCall;
+        i->Cycles = 2;
+    }
+    else if (strcmp(i->Op, "return") == 0 || strcmp(i->Op, "retfie") == 0 ||
+        strcmp(i->Op, "retlw") == 0 || strcmp(i->Op, "reset") == 0)
+    {
+        i->Kind = KRet;
+        i->Cycles = 2;
+    }
+    else if (strcmp(i->Op, "movff") == 0 || strcmp(i->Op, "lfsr") == 0 ||
+        strncmp(i->Op, "tblrd", 5) == 0 || strncmp(i->Op, "tblwt", 5) == 0)
+    {
+        i->Cycles = 2;
+    }
+
+    Operand(i, 0, a0);
+    Operand(i, 1, a1);
+    if ((strcmp(i->Op, "movff") == 0 && IsPC(a1)) ||
+        (i->Kind == KPlain && IsPC(a0) && strcmp(a1, "w") != 0 && strcmp(i->Op, "mulwf") != 0))
+    {
+        i->Kind = KInd;             // Computed jump or call through a pointer
+    }
+}
+
+static int ByAddr(const void * a, const void * b)
+{
+    unsigned long x = ((const Insn *)a)->Addr;
+    unsigned long y = ((const Insn *)b)->Addr;
+
+    return (x > y) - (x < y);
+}
+
+static int At(unsigned long addr)
+{
+    int lo = 0;
+    int hi = NCode - 1;
+    int m;
+
+    while (lo <= hi)
+    {
+        m = (lo + hi) / 2;
+        if (Code[m].Addr == addr)
+        {
+            return m;
+        }
+        if (Code[m].Addr < addr)
+        {
+            lo = m + 1;
+        }
+        else
+        {
+            hi = m - 1;
+        }
+    }
+    return -1;
+}
+
+/*******************************
+ * ReadListing: code lines, labels and the function header blocks
+ *******************************/
+static void ReadListing(FILE * in)
+{
+    char line[512];
+    char * p;
+    char * q;
+    int lineNo = 0;
+    int func = -1;
+    int calls = 0;                  // In the "This function calls:" list
+    int calledBy = 0;               // In the "This function is called by:" list
+    unsigned long addr;
+    Insn * i;
+    int k;
+
+    while (fgets(line, sizeof line, in) != NULL)
+    {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = 0;
+        if ((p = strstr(line, ";; *************** function ")) != NULL)
+        {
+            p += strlen(";; *************** function ");
+            Funcs = Grow(Funcs, NFuncs, sizeof(Func));
+            func = NFuncs++;
+            Copy(Funcs[func].Name, p, strcspn(p, " "), MaxName);
+            Funcs[func].Level = 0;
+            Funcs[func].Required = -1;
+            Funcs[func].At = -1;
+            calls = calledBy = 0;
+            continue;
+        }
+        if ((p = strstr(line, ";;")) != NULL && func >= 0 && (calls || calledBy || strstr(p, "function") || strstr(p, "stack")))
+        {
+            if (strstr(p, "Hardware stack levels required when called:"))
+            {
+                Funcs[func].Required = atoi(strchr(p, ':') + 1);
+            }
+            else if (strstr(p, "This function calls:"))
+            {
+                calls = 1;
+            }
+            else if (strstr(p, "This function is called by:"))
+            {
+                calls = 0;
+                calledBy = 1;
+            }
+            else if (strstr(p, "This function uses") || p[2] == 0)
+            {
+                calls = calledBy = 0;
+            }
+            else if (calls && p[2] == '\t')
+            {
+                p += 2 + strspn(p + 2, "\t ");
+                if (strcmp(p, "Nothing") != 0 && NDecl < MaxDecl)
+                {
+                    Copy(DeclName[NDecl], p, strlen(p), MaxName);
+                    DeclOf[NDecl++] = func;
+                }
+            }
+            else if (calledBy && (q = strstr(p, "Interrupt level ")) != NULL)
+            {
+                Funcs[func].Level = atoi(q + strlen("Interrupt level "));
+            }
+            continue;
+        }
+
+        /* "  10649  003284  340E  F013   \tmovff\t..." or "  10360  000018      _low_isr:" */
+        p = line + strspn(line, " ");
+        if (!isdigit((unsigned char)*p))
+        {
+            continue;
+        }
+        p += strspn(p, "0123456789");
+        p += strspn(p, " ");
+        if (strspn(p, "0123456789ABCDEF") != 6)
+        {
+            continue;
+        }
+        addr = strtoul(p, &p, 16);
+        p += strspn(p, " ");
+        if (strspn(p, "0123456789ABCDEF") == 4 && (p[4] == ' ' || p[4] == '\t'))
+        {
+            Code = Grow(Code, NCode, sizeof(Insn));
+            i = &Code[NCode++];
+            i->Addr = addr;
+            i->Line = lineNo;
+            i->Func = func;
+            i->Words = 1;
+            i->Op0 = (unsigned)strtoul(p, &p, 16);
+            p += strspn(p, " ");
+            if (strspn(p, "0123456789ABCDEF") == 4 && (p[4] == ' ' || p[4] == '\t'))
+            {
+                i->Words = 2;
+                i->Op1 = (unsigned)strtoul(p, &p, 16);
+            }
+            p += strspn(p, " \t");
+            Copy(i->Op, p, strcspn(p, " \t"), sizeof i->Op);
+            p += strcspn(p, " \t");
+            p += strspn(p, " \t");
+            Copy(i->Arg, p, strcspn(p, ";"), MaxArg);
+            Classify(i);
+        }
+        else if ((q = strchr(p, ':')) != NULL && q[1] == 0 && strcspn(p, " \t") == (size_t)(q - p) + 1)
+        {
+            Labels = Grow(Labels, NLabels, sizeof(Label));
+            Copy(Labels[NLabels].Name, p, (size_t)(q - p), MaxName);
+            Labels[NLabels].Addr = addr;
+            Labels[NLabels++].Next = NCode;
+        }
+    }
+    for (k = 0; k < NLabels; k++)   // Before the code is sorted by address
+    {
+        Labels[k].IsCode = Labels[k].Next < NCode && Code[Labels[k].Next].Addr == Labels[k].Addr;
+    }
+}
+
+/*******************************
+ * ReadSymbols: "name ADDR 0 CODE 0" lines of a .sym file, and "name: CODE,
+ * addr 0 size" lines of funclist, as extra labels. Functions in funclist
+ * with no code in the listing are reported.
+ *******************************/
+static void ReadSymbols(FILE * in, int funclist)
+{
+    char line[256];
+    char name[MaxName];
+    char cls[32];
+    unsigned long addr;
+    unsigned long size;
+    int n;
+
+    while (fgets(line, sizeof line, in) != NULL)
+    {
+        if (funclist)
+        {
+            n = sscanf(line, "%63[^:]: %31[^,], %lu 0 %lu", name, cls, &addr, &size);
+        }
+        else
+        {
+            n = sscanf(line, "%63s %lx 0 %31s", name, &addr, cls) + 1;
+        }
+        if (n != 4 || strcmp(cls, "CODE") != 0)
+        {
+            continue;
+        }
+        if (funclist && At(addr) < 0 && size != 0)
+        {
+            printf("note: %s (%lu bytes at 0x%04lX) is not in the listing\n", name, size, addr);
+        }
+        Labels = Grow(Labels, NLabels, sizeof(Label));
+        Copy(Labels[NLabels].Name, name, strlen(name), MaxName);
+        Labels[NLabels].Addr = addr;
+        Labels[NLabels++].IsCode = 1;
+    }
+}
+
+static void ReadBounds(FILE * in)
+{
+    char line[256];
+    char name[MaxName];
+    long n;
+
+    while (fgets(line, sizeof line, in) != NULL)
+    {
+        if (line[0] == '#' || sscanf(line, "%63s %ld", name, &n) != 2 || NBounds >= MaxBounds)
+        {
+            continue;
+        }
+        strcpy(BoundName[NBounds], name);
+        BoundIter[NBounds++] = n;
+    }
+}
+
+static int FindLabel(const char * name)
+{
+    int k;
+
+    for (k = 0; k < NLabels; k++)
+    {
+        if (Labels[k].IsCode && strcmp(Labels[k].Name, name) == 0)
+        {
+            return k;
+        }
+    }
+    return -1;
+}
+
+/*******************************
+ * Decode: target address of a branch or call from its opcode, as assembled,
+ * or -1 (a local label the listing does not show still resolves this way)
+ *******************************/
+static long Decode(const Insn * i)
+{
+    long n;
+
+    if ((i->Op0 & 0xF000) == 0xD000)            // bra, rcall
+    {
+        n = (long)(i->Op0 & 0x07FF) - ((i->Op0 & 0x0400) ? 0x0800 : 0);
+        return (long)i->Addr + 2 + 2 * n;
+    }
+    if ((i->Op0 & 0xF800) == 0xE000)            // bz, bnz, ... bnn
+    {
+        n = (long)(i->Op0 & 0x00FF) - ((i->Op0 & 0x0080) ? 0x0100 : 0);
+        return (long)i->Addr + 2 + 2 * n;
+    }
+    if (i->Words == 2 && ((i->Op0 & 0xFE00) == 0xEC00 || (i->Op0 & 0xFF00) == 0xEF00) && (i->Op1 & 0xF000) == 0xF000)
+    {
+        return 2 * (long)((i->Op0 & 0x00FF) | (i->Op1 & 0x0FFF) << 8);  // call, goto
+    }
+    return -1;
+}
+
+/*******************************
+ * Resolve: code indexes of the branch and call targets (from the opcode,
+ * else "label", "$+n" or an address) and of the function entries
+ *******************************/
+static void Resolve(void)
+{
+    char t[MaxArg];
+    int k;
+    int l;
+
+    for (k = 0; k < NFuncs; k++)
+    {
+        l = FindLabel(Funcs[k].Name);
+        Funcs[k].At = (l >= 0) ? At(Labels[l].Addr) : -1;
+    }
+    for (k = 0; k < NCode; k++)
+    {
+        Code[k].Target = -1;
+        if (Code[k].Kind != KCond && Code[k].Kind != KJump && Code[k].Kind != KCall)
+        {
+            continue;
+        }
+        Operand(&Code[k], 0, t);
+        if (Decode(&Code[k]) >= 0)
+        {
+            Code[k].Target = At((unsigned long)Decode(&Code[k]));
+        }
+        else if (t[0] == '$')
+        {
+            Code[k].Target = At(Code[k].Addr + strtol(t + 1, NULL, 0));
+        }
+        else if ((l = FindLabel(t)) >= 0)
+        {
+            Code[k].Target = At(Labels[l].Addr);
+        }
+        else if (isdigit((unsigned char)t[0]))
+        {
+            Code[k].Target = At(strtoul(t, NULL, 0));
+        }
+    }
+}
+
+/*******************************
+ * FuncAt: the function whose label is at code index k, or -1
+ *******************************/
+static int FuncAt(int k)
+{
+    int f;
+
+    for (f = 0; f < NFuncs; f++)
+    {
+        if (Funcs[f].At == k)
+        {
+            return f;
+        }
+    }
+    return -1;
+}
+
+static const char * Name(int k)
+{
+    static char buf[4][MaxName];
+    static int n;
+    int f = FuncAt(k);
+    int l;
+
+    if (f >= 0)
+    {
+        return Funcs[f].Name;
+    }
+    for (l = 0; l < NLabels; l++)
+    {
+        if (Labels[l].IsCode && Labels[l].Addr == Code[k].Addr)
+        {
+            return Labels[l].Name;
+        }
+    }
+    n = (n + 1) & 3;
+    sprintf(buf[n], "0x%04lX", Code[k].Addr);
+    return buf[n];
+}
+
+/*******************************
+ * Next: code index of the instruction after k in memory, -1 if there is none
+ *******************************/
+static int Next(int k)
+{
+    return (k + 1 < NCode && Code[k+1].Addr == Code[k].Addr + 2 * (unsigned long)Code[k].Words) ? k + 1 : -1;
+}
+
+/*******************************
+ * IsTail: a goto to another function's entry, a jump that does not return
+ *******************************/
+static int IsTail(int k, int entry)
+{
+    return Code[k].Kind == KJump && Code[k].Target >= 0 && Code[k].Target != entry && FuncAt(Code[k].Target) >= 0;
+}
+
+/*******************************
+ * Succ: successors of k inside the function entered at entry, with the
+ * extra cycles when that way is taken. -1 is a successor that is not there.
+ *******************************/
+static int Succ(int k, int entry, int * s, int * extra)
+{
+    int n = Next(k);
+
+    switch (Code[k].Kind)
+    {
+    case KSkip:
+        s[0] = n;
+        extra[0] = 0;
+        s[1] = (n >= 0) ? Next(n) : -1;
+        extra[1] = (n >= 0) ? Code[n].Words : 0;
+        return 2;
+    case KCond:
+        s[0] = n;
+        extra[0] = 0;
+        s[1] = Code[k].Target;
+        extra[1] = 1;
+        return 2;
+    case KJump:
+        if (IsTail(k, entry))
+        {
+            return 0;
+        }
+        s[0] = Code[k].Target;
+        extra[0] = 0;
+        return 1;
+    case KRet:
+    case KInd:
+        return 0;
+    default:
+        s[0] = n;
+        extra[0] = 0;
+        return 1;
+    }
+}
+
+/*******************************
+ * Pointer: the next function after *from that k's function declares as a
+ * callee but never calls directly, -1 when there are no more
+ *******************************/
+static int Pointer(int k, int * from)
+{
+    int d;
+    int j;
+    int f;
+
+    for (d = *from; d < NDecl; d++)
+    {
+        if (DeclOf[d] != Code[k].Func)
+        {
+            continue;
+        }
+        for (j = 0; j < NCode; j++)
+        {
+            if (Code[j].Func == Code[k].Func && (Code[j].Kind == KCall || Code[j].Kind == KJump) &&
+                Code[j].Target >= 0 && strcmp(Name(Code[j].Target), DeclName[d]) == 0)
+            {
+                break;
+            }
+        }
+        if (j < NCode)
+        {
+            continue;
+        }
+        for (f = 0; f < NFuncs; f++)
+        {
+            if (strcmp(Funcs[f].Name, DeclName[d]) == 0 && Funcs[f].At >= 0)
+            {
+                *from = d + 1;
+                return Funcs[f].At;
+            }
+        }
+    }
+    *from = NDecl;
+    return -1;
+}
+
+/*******************************
+ * Walk: depth first search of the code of the function entered at entry.
+ * Fills order with the instructions reached in post order (a callee before
+ * its caller in the graph without its back edges) and marks the back edges
+ * (back[2*k+n] for successor n of k). Returns the count, -1 if the code runs
+ * off its end or branches to an unknown place.
+ *******************************/
+static int Walk(int entry, int * order, char * back, int * mark, const char * why)
+{
+    int * stack = malloc(sizeof(int) * (size_t)NCode);
+    int * next = malloc(sizeof(int) * (size_t)NCode);
+    int s[2];
+    int extra[2];
+    int sp = 0;
+    int count = 0;
+    int n;
+    int k;
+    int ok = 1;
+
+    stack[sp++] = entry;
+    mark[entry] = 1;
+    next[entry] = 0;
+    while (sp > 0)
+    {
+        k = stack[sp-1];
+        n = Succ(k, entry, s, extra);
+        if (next[k] < n)
+        {
+            n = next[k]++;
+            if (s[n] < 0)
+            {
+                fprintf(stderr, "%s: %s at 0x%04lX (line %d) %s\n", why, Name(entry), Code[k].Addr, Code[k].Line,
+                    (Code[k].Kind == KJump || (Code[k].Kind == KCond && n == 1)) ?
+                    "branches to an unknown label" : "runs off the end of the code");
+                ok = 0;
+            }
+            else if (mark[s[n]] == 1)
+            {
+                back[2*k+n] = 1;
+            }
+            else if (mark[s[n]] == 0)
+            {
+                mark[s[n]] = 1;
+                next[s[n]] = 0;
+                stack[sp++] = s[n];
+            }
+            continue;
+        }
+        mark[k] = 2;
+        order[count++] = k;
+        sp--;
+    }
+    free(stack);
+    free(next);
+    return ok ? count : -1;
+}
+
+static long Cycles(int entry);
+
+/*******************************
+ * Depth(entry): return addresses pushed below the code entered at entry at
+ * its deepest, 0 for a leaf, -1 if unknown. A call through a pointer counts
+ * as a call.
+ *******************************/
+static int Depth(int entry)
+{
+    Memo * m = &DepthMemo[entry];
+    int * order;
+    int * mark;
+    char * back;
+    int count;
+    int from;
+    int best = 0;
+    int c;
+    int k;
+    int t;
+    int d;
+
+    if (m->State == 2)
+    {
+        return m->Bad ? -1 : (int)m->Value;
+    }
+    if (m->State == 1)
+    {
+        fprintf(stderr, "stack: recursion through %s\n", Name(entry));
+        return -1;
+    }
+    m->State = 1;
+    order = malloc(sizeof(int) * (size_t)NCode);
+    mark = calloc((size_t)NCode, sizeof(int));
+    back = calloc((size_t)NCode * 2, 1);
+    count = Walk(entry, order, back, mark, "stack");
+    if (count < 0)
+    {
+        m->Bad = 1;
+        count = 0;
+    }
+    for (c = 0; c < count; c++)
+    {
+        k = order[c];
+        from = 0;
+        if (Code[k].Kind == KCall || IsTail(k, entry))
+        {
+            t = Code[k].Target;
+        }
+        else if (Code[k].Kind == KInd)
+        {
+            t = Pointer(k, &from);
+        }
+        else
+        {
+            continue;
+        }
+        if (t < 0)
+        {
+            fprintf(stderr, "stack: %s at 0x%04lX (line %d) in %s has no known target\n",
+                Code[k].Op, Code[k].Addr, Code[k].Line, Name(entry));
+            m->Bad = 1;
+        }
+        for ( ; t >= 0; t = (Code[k].Kind == KInd) ? Pointer(k, &from) : -1)
+        {
+            d = Depth(t);
+            if (d < 0)
+            {
+                m->Bad = 1;
+            }
+            else if (d + (Code[k].Kind != KJump) > best)
+            {
+                best = d + (Code[k].Kind != KJump);
+            }
+        }
+    }
+    free(order);
+    free(mark);
+    free(back);
+    m->State = 2;
+    m->Value = best;
+    return m->Bad ? -1 : best;
+}
+
+/*******************************
+ * Bound(loop): most passes of the loop closed by the back edge from tail.
+ * A decfsz or decf/bnz on a counter set only once, by movlw N/movwf, gives
+ * N; otherwise the bounds file has the figure for the function.
+ *******************************/
+static long Bound(int tail, int entry, const int * order, int count)
+{
+    char ctr[MaxArg];
+    char a[MaxArg];
+    const char * name;
+    int dec = tail - 1;
+    int init = -1;
+    int uses = 0;
+    int c;
+    int b;
+
+    if (dec >= 0 && Next(dec) == tail &&
+        ((strcmp(Code[dec].Op, "decfsz") == 0 && Code[tail].Kind == KJump) ||
+        (strcmp(Code[dec].Op, "decf") == 0 && strcmp(Code[tail].Op, "bnz") == 0)))
+    {
+        Operand(&Code[dec], 0, ctr);
+        for (c = 0; c < count; c++)
+        {
+            Operand(&Code[order[c]], 0, a);
+            if (strcmp(a, ctr) != 0)
+            {
+                Operand(&Code[order[c]], 1, a);
+                if (strcmp(Code[order[c]].Op, "movff") != 0 || strcmp(a, ctr) != 0)
+                {
+                    continue;
+                }
+            }
+            uses++;
+            if (strcmp(Code[order[c]].Op, "movwf") == 0 && order[c] > 0 &&
+                strcmp(Code[order[c]-1].Op, "movlw") == 0 && Next(order[c]-1) == order[c])
+            {
+                init = order[c] - 1;
+            }
+        }
+        if (uses == 2 && init >= 0 && isdigit((unsigned char)Code[init].Arg[0]))
+        {
+            b = atoi(Code[init].Arg) & 0xFF;
+            return b ? b : 256;
+        }
+    }
+
+    name = Name(entry);
+    if (strncmp(name, "i1", 2) == 0 && name[2] == '_')
+    {
+        name += 2;                  // Interrupt copy of a function
+    }
+    for (b = 0; b < NBounds; b++)
+    {
+        if (strcmp(BoundName[b], name) == 0)
+        {
+            return BoundIter[b];
+        }
+    }
+    return -1;
+}
+
+/*******************************
+ * Cycles(entry): longest path in cycles from entry to a return, including
+ * the return and everything called, -1 if it cannot be bounded. Loops are
+ * folded into their header, innermost first (a header comes before the
+ * headers of the loops around it in post order): a loop adds its bound
+ * times its longest pass to the cost of its header.
+ *******************************/
+static long Cycles(int entry)
+{
+    Memo * m = &CycleMemo[entry];
+    int * order;
+    int * mark;
+    int * pos;
+    char * back;
+    char * head;
+    long * w;
+    long * dist;
+    int count;
+    int s[2];
+    int extra[2];
+    int ns;
+    int from;
+    int c;
+    int h;
+    int k;
+    int n;
+    int t;
+    long bound;
+    long pass;
+    long v;
+
+    if (m->State == 2)
+    {
+        return m->Bad ? -1 : m->Value;
+    }
+    if (m->State == 1)
+    {
+        fprintf(stderr, "cycles: recursion through %s\n", Name(entry));
+        return -1;
+    }
+    m->State = 1;
+    order = malloc(sizeof(int) * (size_t)NCode);
+    mark = calloc((size_t)NCode, sizeof(int));
+    back = calloc((size_t)NCode * 2, 1);
+    count = Walk(entry, order, back, mark, "cycles");
+    if (count < 0)
+    {
+        m->Bad = 1;
+        count = 0;
+    }
+    pos = malloc(sizeof(int) * (size_t)NCode);
+    head = calloc((size_t)NCode, 1);
+    w = calloc((size_t)NCode, sizeof(long));
+    dist = malloc(sizeof(long) * (size_t)NCode);
+
+    /* Cost of each instruction, what it calls included, and the loop headers */
+    for (c = 0; c < count; c++)
+    {
+        k = order[c];
+        pos[k] = c;
+        w[k] = Code[k].Cycles;
+        ns = Succ(k, entry, s, extra);
+        for (n = 0; n < ns; n++)
+        {
+            if (back[2*k+n])
+            {
+                head[s[n]] = 1;
+            }
+        }
+        from = 0;
+        if (Code[k].Kind == KCall || IsTail(k, entry))
+        {
+            t = Code[k].Target;
+        }
+        else if (Code[k].Kind == KInd)
+        {
+            t = Pointer(k, &from);
+        }
+        else
+        {
+            continue;
+        }
+        if (t < 0)
+        {
+            fprintf(stderr, "cycles: %s at 0x%04lX (line %d) in %s has no known target\n",
+                Code[k].Op, Code[k].Addr, Code[k].Line, Name(entry));
+            m->Bad = 1;
+        }
+        for (pass = 0; t >= 0; t = (Code[k].Kind == KInd) ? Pointer(k, &from) : -1)
+        {
+            v = Cycles(t);
+            if (v < 0)
+            {
+                m->Bad = 1;
+            }
+            else if (v > pass)
+            {
+                pass = v;
+            }
+        }
+        w[k] += pass;
+    }
+
+    for (h = 0; h < count; h++)
+    {
+        if (!head[order[h]])
+        {
+            continue;
+        }
+        /* Longest pass: from the header to each tail and back, in reverse post order */
+        for (c = 0; c < count; c++)
+        {
+            dist[order[c]] = -1;
+        }
+        dist[order[h]] = w[order[h]];
+        pass = -1;
+        bound = 0;
+        for (c = h; c >= 0; c--)
+        {
+            k = order[c];
+            if (dist[k] < 0)
+            {
+                continue;
+            }
+            ns = Succ(k, entry, s, extra);
+            for (n = 0; n < ns; n++)
+            {
+                if (!back[2*k+n])
+                {
+                    if (dist[k] + extra[n] + w[s[n]] > dist[s[n]])
+                    {
+                        dist[s[n]] = dist[k] + extra[n] + w[s[n]];
+                    }
+                    continue;
+                }
+                if (s[n] != order[h])
+                {
+                    continue;       // Back to an outer loop
+                }
+                if (dist[k] + extra[n] > pass)
+                {
+                    pass = dist[k] + extra[n];
+                }
+                v = Bound(k, entry, order, count);
+                if (v < 0)
+                {
+                    fprintf(stderr, "cycles: no bound for the loop at %s (0x%04lX, line %d) in %s\n",
+                        Name(order[h]), Code[order[h]].Addr, Code[order[h]].Line, Name(entry));
+                    m->Bad = 1;
+                }
+                else if (v > bound)
+                {
+                    bound = v;
+                }
+            }
+        }
+        w[order[h]] += bound * pass;
+    }
+
+    /* Longest path to a return, in post order */
+    for (c = 0; c < count; c++)
+    {
+        k = order[c];
+        ns = Succ(k, entry, s, extra);
+        dist[k] = (ns == 0) ? w[k] : -1;
+        for (n = 0; n < ns; n++)
+        {
+            if (!back[2*k+n] && dist[s[n]] >= 0 && w[k] + extra[n] + dist[s[n]] > dist[k])
+            {
+                dist[k] = w[k] + extra[n] + dist[s[n]];
+            }
+        }
+    }
+    v = (count > 0) ? dist[entry] : -1;
+    if (v < 0 && !m->Bad)
+    {
+        fprintf(stderr, "cycles: %s never returns\n", Name(entry));
+        m->Bad = 1;
+    }
+    free(order);
+    free(mark);
+    free(back);
+    free(pos);
+    free(head);
+    free(w);
+    free(dist);
+    m->State = 2;
+    m->Value = v;
+    return m->Bad ? -1 : v;
+}
+
+/*******************************
+ * Callees: prints every function reached from entry once, with its bound
+ *******************************/
+static void Callees(int entry, char * seen)
+{
+    int * order = malloc(sizeof(int) * (size_t)NCode);
+    int * mark = calloc((size_t)NCode, sizeof(int));
+    char * back = calloc((size_t)NCode * 2, 1);
+    int count = Walk(entry, order, back, mark, "callees");
+    int from;
+    int c;
+    int k;
+    int t;
+
+    for (c = count - 1; c >= 0; c--)
+    {
+        k = order[c];
+        from = 0;
+        t = (Code[k].Kind == KCall || IsTail(k, entry)) ? Code[k].Target : (Code[k].Kind == KInd ? Pointer(k, &from) : -1);
+        while (t >= 0)
+        {
+            if (!seen[t])
+            {
+                seen[t] = 1;
+                if (CycleMemo[t].Bad)
+                {
+                    printf("    %-24s      ?  cycles   %2d levels\n", Name(t), Depth(t));
+                }
+                else
+                {
+                    printf("    %-24s %6ld  cycles   %2d levels\n", Name(t), CycleMemo[t].Value, Depth(t));
+                }
+                Callees(t, seen);
+            }
+            t = (Code[k].Kind == KInd) ? Pointer(k, &from) : -1;
+        }
+    }
+    free(order);
+    free(mark);
+    free(back);
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * f;
+    char * seen;
+    long budget[3] = {0, 0, 0};     // Cycles by interrupt level, 0 for no check
+    long limit = StackLevels;
+    long v;
+    int total = 0;
+    int deepest;
+    int fail = 0;
+    int level;
+    int main_ = -1;
+    int d;
+    int k;
+    int a;
+
+    for (a = 1; a < argc && argv[a][0] == '-' && a + 1 < argc; a += 2)
+    {
+        if (strcmp(argv[a], "-s") == 0)
+        {
+            limit = atol(argv[a+1]);
+        }
+        else if (strcmp(argv[a], "-h") == 0)
+        {
+            budget[2] = atol(argv[a+1]);
+        }
+        else if (strcmp(argv[a], "-l") == 0)
+        {
+            budget[1] = atol(argv[a+1]);
+        }
+        else if (strcmp(argv[a], "-b") == 0 && (f = fopen(argv[a+1], "r")) != NULL)
+        {
+            ReadBounds(f);
+            fclose(f);
+        }
+        else
+        {
+            perror(argv[a+1]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (a >= argc)
+    {
+        fprintf(stderr, "usage: isrcheck [-b bounds] [-s levels] [-h cycles] [-l cycles] listing.lst [file.sym] [funclist]\n");
+        return EXIT_FAILURE;
+    }
+    if ((f = fopen(argv[a], "r")) == NULL)
+    {
+        perror(argv[a]);
+        return EXIT_FAILURE;
+    }
+    ReadListing(f);
+    fclose(f);
+    if (NCode <= 0)
+    {
+        fprintf(stderr, "%s: no code\n", argv[a]);
+        return EXIT_FAILURE;
+    }
+    qsort(Code, (size_t)NCode, sizeof(Insn), ByAddr);
+    for (a++; a < argc; a++)
+    {
+        if ((f = fopen(argv[a], "r")) == NULL)
+        {
+            perror(argv[a]);
+            return EXIT_FAILURE;
+        }
+        ReadSymbols(f, strstr(argv[a], ".sym") == NULL);
+        fclose(f);
+    }
+    Resolve();
+    CycleMemo = calloc((unsigned)NCode, sizeof(Memo));
+    DepthMemo = calloc((unsigned)NCode, sizeof(Memo));
+    seen = calloc((unsigned)NCode, 1);
+
+    for (k = 0; k < NFuncs; k++)
+    {
+        if (strcmp(Funcs[k].Name, "_main") == 0)
+        {
+            main_ = k;
+        }
+    }
+    if (main_ < 0 || Funcs[main_].At < 0)
+    {
+        fprintf(stderr, "no _main in the listing\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("stack (return addresses)\n");
+    d = Depth(Funcs[main_].At);
+    printf("  %-26s %2d", "main", d);
+    if (Funcs[main_].Required >= 0)
+    {
+        printf("     compiler: %d with the interrupts", Funcs[main_].Required);
+    }
+    printf("\n");
+    if (d < 0)
+    {
+        fail = 1;
+    }
+    total = d;
+    for (level = 1; level <= 2; level++)
+    {
+        deepest = 0;                // One ISR per level runs at a time
+        for (k = 0; k < NFuncs; k++)
+        {
+            if (Funcs[k].Level != level || Funcs[k].At < 0)
+            {
+                continue;
+            }
+            d = Depth(Funcs[k].At);
+            printf("  %-26s %2d     interrupt level %d, entry included\n", Funcs[k].Name + 1, d < 0 ? -1 : d + 1, level);
+            if (d < 0)
+            {
+                fail = 1;
+            }
+            else if (d + 1 > deepest)
+            {
+                deepest = d + 1;
+            }
+        }
+        total += deepest;
+    }
+    printf("  %-26s %2d     of %ld%s\n", "worst case", total, limit, total > limit ? "  OVER" : "");
+    if (total > limit)
+    {
+        fail = 1;
+    }
+
+    printf("\ncycles (longest path, %d cycles latency included)\n", IntLatency);
+    for (level = 2; level >= 1; level--)
+    {
+        for (k = 0; k < NFuncs; k++)
+        {
+            if (Funcs[k].Level != level || Funcs[k].At < 0)
+            {
+                continue;
+            }
+            v = Cycles(Funcs[k].At);
+            if (v < 0)
+            {
+                printf("  %-26s      ?  not bounded\n", Funcs[k].Name + 1);
+                fail = 1;
+            }
+            else
+            {
+                printf("  %-26s %6ld", Funcs[k].Name + 1, v + IntLatency);
+                if (budget[level] > 0)
+                {
+                    printf("  budget %ld%s", budget[level], v + IntLatency > budget[level] ? "  OVER" : "");
+                    if (v + IntLatency > budget[level])
+                    {
+                        fail = 1;
+                    }
+                }
+                printf("\n");
+            }
+            Callees(Funcs[k].At, seen);
+        }
+    }
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/*
+ * File:   logdecode.c
+ *
+ * Decodes the EEPROM speed history (see eelog.h for the layout) into CSV on
+ * stdout: record number from the oldest, block, reset flag (1 on the first
+ * record after a power up), mean speed in rev/s and mean duty. The log is
+ * taken from the block frames of a telemetry capture (the dump sent after
+ * every reset), or with -i from a raw EEPROM image such as the one the
+ * simulator keeps with -e. Blocks are put in order from their sequence
+ * numbers, the same way the firmware finds where to carry on.
+ *
+ * Build: make -C tools logdecode
+ * Use:   tools/logdecode capture.bin > log.csv
+ *        tools/logdecode -i eeprom.bin > log.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../globals.h"
+#include "../telemetry.h"
+#include "../eelog.h"
+
+static unsigned char Image[LogBlocks * LogBlockSize];
+static int Have[LogBlocks];
+
+/*******************************
+ * Crc8: CRC-8, polynomial 0x07, bitwise (the firmware uses a table)
+ *******************************/
+static unsigned char Crc8(const unsigned char * p, int n)
+{
+    unsigned char crc = 0;
+    int i;
+
+    while (n-- > 0)
+    {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*******************************
+ * ReadCapture: keeps the last good block frame of each block
+ *******************************/
+static void ReadCapture(FILE * in)
+{
+    unsigned char f[TlmBlockLen];
+    int n = 0;
+    int c;
+    int i;
+
+    while ((c = getc(in)) != EOF)
+    {
+        f[n++] = (unsigned char)c;
+        if (f[0] != TlmBlockSync)
+        {
+            n = 0;
+            continue;
+        }
+        if (n < TlmBlockLen)
+        {
+            continue;
+        }
+        if (Crc8(f+1, TlmBlockLen-2) != f[TlmBlockLen-1] || f[1] >= LogBlocks)
+        {
+            for (i = 1; i < n && f[i] != TlmBlockSync; i++)
+            {
+                ;                           // Resync on the next sync byte
+            }
+            n -= i;
+            memmove(f, f+i, (size_t)n);
+            continue;
+        }
+        memcpy(Image + f[1] * LogBlockSize, f+2, LogBlockSize);
+        Have[f[1]] = 1;
+        n = 0;
+    }
+}
+
+static int Header(int b)
+{
+    int h = Image[b * LogBlockSize];
+
+    return (Have[b] && (h & ~LogBootFlag) < LogSeqMod) ? h : -1;
+}
+
+/*******************************
+ * Newest: the block whose successor does not carry the next sequence number
+ *******************************/
+static int Newest(void)
+{
+    int b;
+    int h;
+    int n;
+
+    for (b = 0; b < LogBlocks; b++)
+    {
+        if ((h = Header(b)) < 0)
+        {
+            continue;
+        }
+        n = Header((b + 1) % LogBlocks);
+        if (n < 0 || (n & ~LogBootFlag) != ((h & ~LogBootFlag) + 1) % LogSeqMod)
+        {
+            return b;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * in = stdin;
+    const unsigned char * p;
+    int raw = 0;
+    int newest;
+    int k;
+    int b;
+    int i;
+    int r = 0;
+    int d = 0;
+    int boot;
+    unsigned long records = 0;
+    unsigned long blocks = 0;
+    int c;
+
+    if (argc > 1 && strcmp(argv[1], "-i") == 0)
+    {
+        raw = 1;
+        argc--;
+        argv++;
+    }
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: logdecode [-i eeprom.bin | capture.bin]\n");
+        return EXIT_FAILURE;
+    }
+    if (argc == 2 && (in = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (raw)
+    {
+        for (i = 0; i < LogBase && getc(in) != EOF; i++)
+        {
+            ;
+        }
+        if (fread(Image, 1, sizeof Image, in) != sizeof Image)
+        {
+            fprintf(stderr, "short EEPROM image\n");
+            return EXIT_FAILURE;
+        }
+        for (b = 0; b < LogBlocks; b++)
+        {
+            Have[b] = 1;
+        }
+    }
+    else
+    {
+        ReadCapture(in);
+    }
+
+    printf("record,block,reset,rps,duty\n");
+    newest = Newest();
+    for (k = 1; newest >= 0 && k <= LogBlocks; k++)
+    {
+        b = (newest + k) % LogBlocks;       // Oldest first
+        if (Header(b) < 0)
+        {
+            continue;
+        }
+        blocks++;
+        boot = (Header(b) & LogBootFlag) != 0;
+        p = Image + b * LogBlockSize;
+        for (i = 1; i < LogBlockSize && p[i] != LogEnd; )
+        {
+            c = p[i];
+            if ((c & 0x80) == 0)
+            {
+                r += ((c >> 3) & 0x0F) - ((c & 0x40) ? 16 : 0);
+                d += (c & 0x07) - ((c & 0x04) ? 8 : 0);
+                i += 1;
+            }
+            else if ((c & 0xC0) == LogMid && i + 1 < LogBlockSize)
+            {
+                d += (c & 0x3F) - ((c & 0x20) ? 64 : 0);
+                r += (signed char)p[i+1];
+                i += 2;
+            }
+            else if ((c & 0xE0) == LogAbs && i + 3 < LogBlockSize)
+            {
+                r = (short)(p[i+1] | p[i+2] << 8);
+                d = p[i+3];
+                i += 4;
+            }
+            else
+            {
+                fprintf(stderr, "block %d: bad record 0x%02X at %d\n", b, c, i);
+                break;
+            }
+            printf("%lu,%d,%d,%.2f,%d\n", records, b, boot, r * LogRPSUnit / (double)RPSScale, d * 4);
+            boot = 0;
+            records++;
+        }
+    }
+
+    fprintf(stderr, "%lu records in %lu blocks\n", records, blocks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/*
+ * File:   obsbench.c
+ *
+ * Host-side comparison of the alpha-beta observer (observer.c, every Timer2
+ * tick) against the sliding window estimate (SpeedWindowUpdate in speed.c,
+ * every 25 ms), both built from the firmware sources and run at their real
+ * tick times. The shaft position is quantized to whole counts, optionally
+ * with edge placement noise (line position error of the encoder disk).
+ * Reported per case, in milli-rev/s against the true speed at each Timer2
+ * tick:
+ *
+ *   constant speed   mean error (bias) and RMS error (noise)
+ *   speed step       time to 90% of the step and overshoot
+ *   ramp             mean error while accelerating (tracking lag)
+ *
+ * Build: make -C tools obsbench && tools/obsbench [edge noise, counts]
+ * Other gains: make -C tools -B obsbench CFLAGS="-O2 -I.. -DObsGammaShift=17"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../system.h"
+#include "../globals.h"
+#include "../speed.h"
+#include "../observer.h"
+
+long EncoderPos[AxisCount];
+long EncoderLastPos[AxisCount];
+long CHAcount[AxisCount];
+
+unsigned int ReadTimer1(void)       // SpeedMTUpdate and SpeedT2Periods only, not used here
+{
+    return 0;
+}
+
+unsigned int ReadTimer3(void)
+{
+    return 0;
+}
+
+unsigned char SimTimer2(void)
+{
+    return 0;
+}
+
+#define BenchMs 6000                // Length of each run (ms)
+#define BenchSettle 3000            // Steady state is measured after this (ms)
+#define BenchStepAt 3000            // Step and ramp start (ms)
+#define BenchCyclesMs (SYS_FREQ/4000) // Instruction cycles per ms
+
+typedef struct
+{
+    double Sum;
+    double Sq;
+    long N;
+    long Rise;                      // ms from the step to 90%, -1 if never
+    double Peak;
+} BenchStat;
+
+static double Noise;                // Edge placement noise, +/- counts (uniform)
+
+static double Uniform(void)
+{
+    return (double)rand() / RAND_MAX * 2.0 - 1.0;
+}
+
+/*******************************
+ * Measure: the true position at cycle time t, quantized by the encoder.
+ *******************************/
+static long Measure(double (*f)(long), double * theta, long * last, long t)
+{
+    *theta += f(t / BenchCyclesMs) * EncoderCPR * (t - *last) / (SYS_FREQ/4);
+    *last = t;
+    return (long)floor(*theta + Noise * Uniform());
+}
+
+/*******************************
+ * Run: drives both estimators with the speed profile f (rev/s at t ms) at
+ * their real tick times, the observer every Timer2 period and the window
+ * every 25 ms, and collects the error statistics at every Timer2 tick from
+ * time from. With a target the rise time to 90% of the change from the speed
+ * before from and the peak are kept.
+ *******************************/
+static void Run(double (*f)(long), long from, double target, BenchStat * w, BenchStat * o)
+{
+    double theta = 0.0;             // True position, counts
+    double start = f(from - 1);
+    long last = 0;
+    long next0 = SpeedTickMs * BenchCyclesMs;
+    long win = 0;
+    long obs = 0;
+    long t;
+    double e;
+
+    srand(1);
+    EncoderPos[0] = 0;
+    SpeedWindowInit();
+    ObsInit(0, 0);
+    w->Sum = w->Sq = o->Sum = o->Sq = 0.0;
+    w->N = o->N = 0;
+    w->Rise = o->Rise = -1;
+    w->Peak = o->Peak = start;
+    for (t = ObsTickCycles; t < BenchMs * BenchCyclesMs; t += ObsTickCycles)
+    {
+        if (next0 <= t)             // Sample tick first
+        {
+            EncoderPos[0] = Measure(f, &theta, &last, next0);
+            win = SpeedWindowUpdate(0);
+            next0 += SpeedTickMs * BenchCyclesMs;
+        }
+        EncoderPos[0] = Measure(f, &theta, &last, t);
+        obs = ObsUpdate(0, EncoderPos[0], 1);
+        if (t < from * BenchCyclesMs)
+        {
+            continue;
+        }
+        e = win / (double)RPSScale - f(t / BenchCyclesMs);
+        w->Sum += e;
+        w->Sq += e * e;
+        w->N++;
+        e = obs / (double)RPSScale - f(t / BenchCyclesMs);
+        o->Sum += e;
+        o->Sq += e * e;
+        o->N++;
+        if (target != 0.0)
+        {
+            if (w->Rise < 0 && (win / (double)RPSScale - start) >= 0.9 * (target - start))
+            {
+                w->Rise = t / BenchCyclesMs - from;
+            }
+            if (o->Rise < 0 && (obs / (double)RPSScale - start) >= 0.9 * (target - start))
+            {
+                o->Rise = t / BenchCyclesMs - from;
+            }
+            if (win / (double)RPSScale > w->Peak)
+            {
+                w->Peak = win / (double)RPSScale;
+            }
+            if (obs / (double)RPSScale > o->Peak)
+            {
+                o->Peak = obs / (double)RPSScale;
+            }
+        }
+    }
+}
+
+static double Speed;                // Constant speed case (rev/s)
+
+static double Constant(long t)
+{
+    return Speed;
+}
+
+static double Step(long t)
+{
+    return (t < BenchStepAt) ? 2.0 : 10.0;
+}
+
+static double Ramp(long t)          // 2 rev/s, then +10 rev/s^2
+{
+    return (t < BenchStepAt) ? 2.0 : 2.0 + 10.0 * (t - BenchStepAt) / 1000.0;
+}
+
+int main(int argc, char ** argv)
+{
+    static const double speeds[] = {0.37, 1.13, 2.71, 5.9, 13.3, 23.7};
+    BenchStat w;
+    BenchStat o;
+    unsigned char i;
+
+    if (argc > 1)
+    {
+        Noise = atof(argv[1]);
+    }
+    printf("observer alpha 1/%d beta 1/%d gamma 1/%ld every %ld cycles, window %d x %d ms, edge noise +/-%.2f counts\n",
+        1 << ObsAlphaShift, 1 << ObsBetaShift, ObsGammaShift ? 1L << ObsGammaShift : 0L,
+        ObsTickCycles, SpeedWinTicks, SpeedTickMs, Noise);
+    printf("\nconstant   window mean    rms     observer mean    rms   (milli-rev/s)\n");
+    for (i = 0; i < sizeof(speeds)/sizeof(speeds[0]); i++)
+    {
+        Speed = speeds[i];
+        Run(Constant, BenchSettle, 0.0, &w, &o);
+        printf("%5.2f rev/s     %8.2f %7.2f         %8.2f %7.2f\n", Speed,
+            1000.0 * w.Sum / w.N, 1000.0 * sqrt(w.Sq / w.N),
+            1000.0 * o.Sum / o.N, 1000.0 * sqrt(o.Sq / o.N));
+    }
+
+    Run(Step, BenchStepAt, 10.0, &w, &o);
+    printf("\nstep 2 -> 10 rev/s   to 90%%     overshoot\n");
+    printf("window             %5ld ms   %6.3f rev/s\n", w.Rise, w.Peak - 10.0);
+    printf("observer           %5ld ms   %6.3f rev/s\n", o.Rise, o.Peak - 10.0);
+
+    Run(Ramp, BenchStepAt + 500, 0.0, &w, &o);
+    printf("\nramp 10 rev/s^2      mean error\n");
+    printf("window             %8.1f milli-rev/s\n", 1000.0 * w.Sum / w.N);
+    printf("observer           %8.1f milli-rev/s\n", 1000.0 * o.Sum / o.N);
+    return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * File:   quadcheck.c
+ *
+ * Host-side check of the SpeedEdgeISR decode on synthetic A/B waveforms: the
+ * high_isr macros of encoder.h, through either input, and the firmware
+ * ReadEncoder (user.c) that folds their counters into EncoderPos,
+ * EncoderErrors and EncoderMissed. Each case builds its pin sequence step by
+ * step with the count every step should give, runs it with a ReadEncoder
+ * call every FoldSteps steps and once at the end, and compares the three
+ * totals of every axis exactly. Axis 1, when built, turns the other way.
+ *
+ *   cw        whole revolutions clockwise (+1 a step)
+ *   ccw       the same counter clockwise
+ *   reversal  back and forth, turning on every step of the cycle
+ *   illegal   both channels of a pair at once among legal steps: an error
+ *             and a missed edge, the position left alone
+ *   empty     RB change interrupts with no pin changed: a missed edge on
+ *             every axis (RB change only; the sampled input has none)
+ *   table     every old and new pair of each axis through one EncLatch and
+ *             EncDecode, against the packed QEM table of the decoder that
+ *             the bit tests replaced (encoder.h): the same step, or illegal
+ *
+ * rb runs each step as one RB change interrupt, sampled as EncFilterN
+ * Timer0 samples of the new levels. The protection budgets are refilled
+ * before every step, so none trips.
+ *
+ * Build: make -C tools quadcheck && tools/quadcheck
+ * Two axes: make -C tools -B quadcheck CFLAGS="-O2 -Wall -I.. -DAxisCount=2"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <xc.h>
+#include <timers.h>
+#include "../system.h"
+#include "../hal.h"
+#include "../globals.h"
+#include "../protect.h"
+#include "../encoder.h"
+#include "../user.h"
+#include "../lcd.h"
+#include "../format.h"
+#include "../snapshot.h"
+
+#define FoldSteps 100               // Steps between ReadEncoder calls, fewer than 256 of a kind
+#define CaseSteps 4000              // Steps of each case (two revolutions)
+
+// The decoder state, as main.c declares it
+unsigned char EncoderState;
+long EncoderPos[AxisCount];
+unsigned int EncoderErrors[AxisCount];
+unsigned int EncoderMissed[AxisCount];
+volatile unsigned char EdgeUp[AxisCount];
+volatile unsigned char EdgeDown[AxisCount];
+volatile unsigned char EdgeIllegal[AxisCount];
+volatile unsigned char EdgeNone;
+unsigned char EdgeDiff;
+unsigned char EncFilt;
+unsigned char EncCnt0;
+unsigned char EncCnt1;
+unsigned char EncCnt2;
+unsigned int PulseLast;
+
+volatile unsigned char ProtFault;
+volatile unsigned char ProtEdges[AxisCount];
+volatile unsigned char ProtIllegal[AxisCount];
+
+// What the rest of user.c calls, not used here
+void LCDInit(const char * seq) { (void)seq; }
+void LCDWrite(const char * str) { (void)str; }
+int FormatFixed(char * buf, long var, unsigned char scale, unsigned char width,
+                unsigned char prec, char over) { (void)buf; (void)var; (void)scale; (void)width;
+                (void)prec; (void)over; return 0; }
+void SnapRead(SpeedSnap * s) { (void)s; }
+unsigned int ReadTimer1(void) { return 0; }
+void WriteTimer1(unsigned int timer1) { (void)timer1; }
+
+static const unsigned char Gray[4] = {0, 2, 3, 1}; // A,B levels in clockwise order (old A == new B)
+
+// The table ReadEncoder indexed before high_isr took the decode (user.c)
+#define QEMIllegal 2                // Entry for an illegal transition (both channels changed)
+static const signed char QEM[16] = {0,-1,1,2,1,0,2,-1,-1,2,0,1,2,1,-1,0}; // Step per old*4+new state
+
+static unsigned char Phase[AxisCount];  // Position of each axis in Gray
+static long WantPos[AxisCount];
+static unsigned int WantErrors[AxisCount];
+static unsigned int WantMissed[AxisCount];
+static int Sampled;                     // Input under test
+
+/*******************************
+ * Pins: the encoder bits of every axis at their Phase
+ *******************************/
+static unsigned char Pins(void)
+{
+    unsigned char p = 0;
+    int a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        p |= (unsigned char)(Gray[Phase[a]] << (2*a));
+    }
+    return p;
+}
+
+/*******************************
+ * Interrupt: high_isr on the pins, with the budgets refilled
+ *******************************/
+static void Interrupt(unsigned char pins)
+{
+    int a;
+    int i;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        ProtEdges[a] = ProtEdgesCap;
+        ProtIllegal[a] = ProtIllegalMax;
+    }
+    if (Sampled)
+    {
+        for (i = 0; i < EncFilterN; i++)
+        {
+            EncFilter(pins);
+            EncDecode();
+        }
+    }
+    else
+    {
+        EncLatch(pins);
+        EncDecode();
+    }
+}
+
+/*******************************
+ * Step: moves axis 0 by d quarter cycles (+1, -1, or 2 for both channels at
+ * once) and axis 1 the opposite way, in one interrupt
+ *******************************/
+static void Step(int d)
+{
+    int a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        int m = (a & 1) && d != 2 ? -d : d;
+
+        Phase[a] = (unsigned char)((Phase[a] + m + 4) & 3);
+        if (d == 2)
+        {
+            WantErrors[a]++;
+            WantMissed[a]++;
+        }
+        else
+        {
+            WantPos[a] += m;
+        }
+    }
+    Interrupt(Pins());
+}
+
+/*******************************
+ * Empty: an RB change interrupt where no pin changed
+ *******************************/
+static void Empty(void)
+{
+    int a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        WantMissed[a]++;
+    }
+    Interrupt(Pins());
+}
+
+/*******************************
+ * Run: resets the decoder and the totals, runs case c and compares them
+ *******************************/
+static int Run(const char * name, int c)
+{
+    int a;
+    int n;
+    int bad = 0;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        Phase[a] = 0;
+        EncoderPos[a] = WantPos[a] = 0; // ReadEncoder carries on from its last counter values
+        EncoderErrors[a] = WantErrors[a] = 0;
+        EncoderMissed[a] = WantMissed[a] = 0;
+    }
+    EncoderState = Pins();
+    EncFilt = EncoderState;
+    EncCnt0 = EncCnt1 = EncCnt2 = 0;
+
+    for (n = 1; n <= CaseSteps; n++)
+    {
+        switch (c)
+        {
+            case 0: Step(1); break;
+            case 1: Step(-1); break;
+            case 2: Step((n / 7) & 1 ? -1 : 1); break; // Turns every 7 steps, on every phase
+            case 3: Step(n % 13 == 0 ? 2 : 1); break;
+            case 4: if (n % 11 == 0) Empty(); else Step(-1); break;
+        }
+        if (n % FoldSteps == 0)
+        {
+            ReadEncoder();
+        }
+    }
+    ReadEncoder();
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        if (EncoderPos[a] != WantPos[a] || EncoderErrors[a] != WantErrors[a] ||
+            EncoderMissed[a] != WantMissed[a])
+        {
+            bad = 1;
+        }
+        printf("%-8s %-9s axis %d: pos %+6ld errors %4u missed %4u, want %+6ld %4u %4u%s\n",
+               Sampled ? "sampled" : "rb", name, a, EncoderPos[a], EncoderErrors[a], EncoderMissed[a],
+               WantPos[a], WantErrors[a], WantMissed[a], EncoderPos[a] != WantPos[a] ||
+               EncoderErrors[a] != WantErrors[a] || EncoderMissed[a] != WantMissed[a] ? "  FAIL" : "");
+    }
+    return bad;
+}
+
+/*******************************
+ * Table: one RB change interrupt for every old and new pair of each axis,
+ * the other axes still, against QEM
+ *******************************/
+static int Table(void)
+{
+    int a;
+    int i;
+    int bad = 0;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        int off = 0;
+
+        for (i = 0; i < 16; i++)
+        {
+            unsigned char up = EdgeUp[a];
+            unsigned char down = EdgeDown[a];
+            unsigned char illegal = EdgeIllegal[a];
+            int step;
+
+            ProtEdges[a] = ProtEdgesCap;
+            ProtIllegal[a] = ProtIllegalMax;
+            EncoderState = (unsigned char)((i >> 2) << (2*a));
+            EncLatch((unsigned char)((i & 3) << (2*a)));
+            EncDecode();
+            step = (unsigned char)(EdgeIllegal[a] - illegal) != 0 ? QEMIllegal :
+                   (unsigned char)(EdgeUp[a] - up) - (unsigned char)(EdgeDown[a] - down);
+            if (step != QEM[i])
+            {
+                off++;
+            }
+        }
+        printf("rb       table     axis %d: %d of 16 transitions off QEM%s\n", a, off, off ? "  FAIL" : "");
+        bad += off != 0;
+    }
+    return bad;
+}
+
+int main(void)
+{
+    static const char * const Names[5] = {"cw", "ccw", "reversal", "illegal", "empty"};
+    int c;
+    int bad = 0;
+
+    for (Sampled = 0; Sampled <= 1; Sampled++)
+    {
+        for (c = 0; c < (Sampled ? 4 : 5); c++)
+        {
+            bad += Run(Names[c], c);
+        }
+    }
+    bad += Table();
+    if (ProtFault != 0)
+    {
+        printf("protection tripped: fault 0x%02X\n", ProtFault);
+        bad++;
+    }
+    printf("%d cases failed\n", bad);
+    return bad == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,106 @@
+/*
+ * File:   rpscheck.c
+ *
+ * Host-side check of the fixed point speed of the sliding window
+ * (SpeedWindowUpdate in speed.c) against the double formula it replaced,
+ * counts / CountPerRev over the sample time, for every window sum the
+ * firmware can hold at every window length: one tick of counts per slot up
+ * to an int, the sum times SpeedGainQ8 up to a long. The window is filled
+ * through SpeedWindowUpdate itself, one EncoderPos step per sample tick.
+ * The integer result must be the double one rounded down, to the milli-rev/s.
+ * Built with SIM, the slot and the product are range checked (FitInt and
+ * FitLong, globals.h) as the PIC's 16 bit int and 32 bit long hold them.
+ *
+ * Build: make -C tools rpscheck && tools/rpscheck
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../system.h"
+#include "../globals.h"
+#include "../speed.h"
+#include "../observer.h"
+
+long EncoderPos[AxisCount];
+long EncoderLastPos[AxisCount];
+long CHAcount[AxisCount];
+const int CountPerRev = EncoderCPR;
+
+unsigned int ReadTimer1(void)       // SpeedMTUpdate and SpeedT2Periods only, not used here
+{
+    return 0;
+}
+
+unsigned int ReadTimer3(void)
+{
+    return 0;
+}
+
+unsigned char SimTimer2(void)
+{
+    return 0;
+}
+
+/*******************************
+ * Window: fills the window of 2^shift ticks with counts summing to sum, one
+ * count more in the first ticks for the remainder so that every tick fits an
+ * int, and returns the last SpeedWindowUpdate.
+ *******************************/
+static long Window(unsigned char shift, long sum)
+{
+    long q = sum >> shift;          // Counts of every tick...
+    long rem = sum - (q << shift);  // ... and one more in the first rem
+    long r = 0;
+    int i;
+
+    SpeedWindowInit();
+    SpeedWindowResize(shift);
+    for (i = 0; i < (1 << shift); i++)
+    {
+        EncoderPos[0] += q + (i < rem);
+        r = SpeedWindowUpdate(0);
+    }
+    return r;
+}
+
+int main(void)
+{
+    unsigned char shift;
+    long sum;
+    long top;
+    long got;
+    double want;
+    double err;
+    double worst;
+    long worstsum;
+    unsigned long bad = 0;
+
+    for (shift = 0; shift <= SpeedWinLog2; shift++)
+    {
+        top = 32767L << shift;                      // Slots are ints
+        if (top > 0x7FFFFFFFL / SpeedGainQ8)
+        {
+            top = 0x7FFFFFFFL / SpeedGainQ8;        // ... and the product a long
+        }
+        worst = 0.0;
+        worstsum = 0;
+        for (sum = -top; sum <= top; sum++)
+        {
+            got = Window(shift, sum);
+            want = (double)sum / CountPerRev / ((1 << shift) * SpeedTickMs / 1000.0) * RPSScale;
+            err = got - floor(want + 1e-9);        // Exact quotients may come out a hair low
+            if (fabs(err) > fabs(worst))
+            {
+                worst = err;
+                worstsum = sum;
+            }
+            bad += (err != 0.0);
+        }
+        printf("window %2d ticks  sums +/-%-7ld (%.1f rev/s)  worst %+.0f milli-rev/s at %ld\n",
+               1 << shift, top, (double)top / CountPerRev / ((1 << shift) * SpeedTickMs / 1000.0),
+               worst, worstsum);
+    }
+    printf("%lu sums off the double formula\n", bad);
+    return bad == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+/*
+ * File:   snapstress.c
+ *
+ * Host-side check of the speed snapshot (snapshot.c). The Timer2 ISR
+ * publication is run between every pair of bytes the reader copies, once and
+ * then twice per read (the second one landing in the retry), and every
+ * snapshot returned must be one complete publication. The same schedule is
+ * run against a plain byte by byte copy of the globals to show the tears the
+ * snapshot prevents.
+ *
+ * Build: make -C tools snapstress && tools/snapstress
+ * Two axes: make -C tools -B snapstress CFLAGS="-O2 -Wall -I.. -DAxisCount=2"
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SnapByteHook(i) StressHook()
+static void StressHook(void);
+
+#include "../snapshot.c"
+
+long EncoderPos[AxisCount];
+long RPS[AxisCount];
+long CHAcount[AxisCount];
+unsigned int Duty[AxisCount];
+
+static unsigned int Writes;         // Publications so far
+static int FireAt[2];               // Reader byte positions to publish at (-1: never)
+static int Fired;
+static int Hook;                    // Bytes copied so far in the current read
+
+/*******************************
+ * Publish: the Timer2 ISR. Every field is derived from the publication
+ * number and changes in every byte, so a mix of two publications shows.
+ *******************************/
+static void Publish(void)
+{
+    int a;
+
+    Writes++;
+    for (a = 0; a < AxisCount; a++)
+    {
+        EncoderPos[a] = (long)(Writes * 0x01010101UL) + a;
+        RPS[a] = -EncoderPos[a];
+        CHAcount[a] = (long)(Writes * 0x01010101UL) - a;
+        Duty[a] = Writes * 0x01010101U + a;
+    }
+    SnapPublish();
+}
+
+static void StressHook(void)
+{
+    if (Fired < 2 && FireAt[Fired] == Hook)
+    {
+        Fired++;
+        Publish();
+    }
+    Hook++;
+}
+
+static int Consistent(const SpeedSnap * s)
+{
+    unsigned int k = s->Time;
+    int a;
+
+    for (a = 0; a < AxisCount; a++)
+    {
+        if (s->Pos[a] != (long)(k * 0x01010101UL) + a || s->RPS[a] != -s->Pos[a] ||
+            s->Count[a] != (long)(k * 0x01010101UL) - a || s->Duty[a] != k * 0x01010101U + a)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void CopyBytes(void * dst, const volatile void * src, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        StressHook();
+        ((unsigned char *)dst)[i] = ((const volatile unsigned char *)src)[i];
+    }
+}
+
+/*******************************
+ * PlainRead: what the main loop did before, reading the globals directly
+ *******************************/
+static void PlainRead(SpeedSnap * s)
+{
+    CopyBytes(&s->Time, &Writes, sizeof s->Time);
+    CopyBytes(s->Pos, EncoderPos, sizeof s->Pos);
+    CopyBytes(s->RPS, RPS, sizeof s->RPS);
+    CopyBytes(s->Count, CHAcount, sizeof s->Count);
+    CopyBytes(s->Duty, Duty, sizeof s->Duty);
+}
+
+static void Arm(int a, int b)
+{
+    FireAt[0] = a;
+    FireAt[1] = b;
+    Fired = 0;
+    Hook = 0;
+}
+
+int main(void)
+{
+    const int n = (int)sizeof(SpeedSnap);
+    SpeedSnap s;
+    int a;
+    int b;
+    unsigned long reads = 0;
+    unsigned long bad = 0;
+    unsigned long retries = 0;
+    unsigned long plain = 0;
+    unsigned long torn = 0;
+
+    Publish();
+    for (a = -1; a < n; a++)            // First publication before byte a
+    {
+        for (b = a+1; b < 3*n; b++)     // Second before byte b, counting retries
+        {
+            Arm(a < 0 ? b : a, a < 0 ? -1 : b);
+            SnapRead(&s);
+            reads++;
+            retries += Hook/n - 1;
+            bad += !Consistent(&s);
+        }
+    }
+
+    for (a = 0; a < n; a++)             // Plain copy, one publication before byte a
+    {
+        Arm(a, -1);
+        PlainRead(&s);
+        plain++;
+        torn += !Consistent(&s);
+    }
+
+    printf("snapshot  %lu reads, %lu retries, %lu inconsistent\n", reads, retries, bad);
+    printf("plain     %lu reads, %lu torn\n", plain, torn);
+    return bad == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+/*
+ * File:   tlmdecode.c
+ *
+ * Decodes the USART telemetry stream (see telemetry.h for the frame) into CSV
+ * on stdout: seq, time in ms, position in counts, speed in rev/s, duty and the
+ * number of frames lost before this one (from the sequence gap). The stream
+ * is searched for the sync byte and a frame is only accepted when its CRC
+ * matches, so it resynchronises after line noise or a partial capture.
+ * Replies to commands (tools/cmdsend) are printed to stderr as they come, and
+ * the totals at the end.
+ *
+ * Build: make -C tools tlmdecode
+ * Use:   tools/tlmdecode capture.bin > run.csv   (or from stdin, e.g. a serial
+ *        port set to 57600 8N1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../globals.h"
+#include "../telemetry.h"
+#include "../command.h"
+
+/*******************************
+ * Crc8: CRC-8, polynomial 0x07, bitwise (the firmware uses a table)
+ *******************************/
+static unsigned char Crc8(const unsigned char * p, int n)
+{
+    unsigned char crc = 0;
+    int i;
+
+    while (n-- > 0)
+    {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static unsigned Word(const unsigned char * p)
+{
+    return p[0] | (unsigned)p[1] << 8;
+}
+
+static long Long(const unsigned char * p)
+{
+    return (long)(int)(Word(p) | (unsigned long)Word(p+2) << 16);
+}
+
+/*******************************
+ * Length: frame length for the sync byte b, 0 if b starts no frame
+ *******************************/
+static int Length(unsigned char b)
+{
+    return (b == TlmSyncByte) ? TlmFrameLen : (b == TlmReplySync) ? TlmReplyLen : 0;
+}
+
+/*******************************
+ * Reply: prints a command reply frame
+ *******************************/
+static void Reply(const unsigned char * f)
+{
+    static const char * const name[] = {"?", "speed", "rps", "duty", "kp", "ki", "window", "stats", "fault", "cal", "capture"};
+    static const char * const status[] = {"ok", "bad parameter", "bad axis", "bad value", "faulted", "busy"};
+    unsigned p = f[1] & ~CmdSet;
+
+    fprintf(stderr, "reply %s %s axis %u: %s, %ld\n", (f[1] & CmdSet) ? "set" : "get",
+            name[p < sizeof name / sizeof name[0] ? p : 0], f[2],
+            f[3] < sizeof status / sizeof status[0] ? status[f[3]] : "?", Long(f+4));
+}
+
+int main(int argc, char * argv[])
+{
+    FILE * in = stdin;
+    unsigned char f[TlmFrameLen];
+    int n = 0;
+    int c;
+    int i;
+    int seq = -1;
+    int lost;
+    unsigned long frames = 0;
+    unsigned long replies = 0;
+    unsigned long lostTotal = 0;
+    unsigned long skipped = 0;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [capture.bin]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc == 2 && (in = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    printf("seq,time_ms,pos,rps,duty,lost\n");
+    while ((c = getc(in)) != EOF)
+    {
+        f[n++] = (unsigned char)c;
+        if (Length(f[0]) == 0)
+        {
+            n = 0;
+            skipped++;
+            continue;
+        }
+        if (n < Length(f[0]))
+        {
+            continue;
+        }
+        if (Crc8(f+1, n-2) != f[n-1])
+        {
+            for (i = 1; i < n && Length(f[i]) == 0; i++)
+            {
+                ;                           // Resync on the next sync byte
+            }
+            skipped += i;
+            n -= i;
+            for (c = 0; c < n; c++)
+            {
+                f[c] = f[c+i];
+            }
+            continue;
+        }
+        if (f[0] == TlmReplySync)
+        {
+            Reply(f);
+            replies++;
+            n = 0;
+            continue;
+        }
+        lost = (seq < 0) ? 0 : (f[1] - seq - 1) & 0xFF;
+        seq = f[1];
+        printf("%u,%u,%ld,%.3f,%u,%d\n", f[1], Word(f+2), Long(f+4),
+               Long(f+8) / (double)RPSScale, Word(f+12), lost);
+        frames++;
+        lostTotal += lost;
+        n = 0;
+    }
+
+    fprintf(stderr, "%lu frames, %lu lost, %lu replies, %lu bytes skipped\n", frames, lostTotal,
+            replies, skipped);
+    return EXIT_SUCCESS;
+}
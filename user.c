@@ -7,17 +7,36 @@
 #include <stdbool.h>        /* For true/false definition */
 #include <string.h>
 #include <delays.h>
-#include <stdio.h>
+#include "timers.h"
+#include "hal.h"
+#include "system.h"
 #include "globals.h"
+#include "speed.h"
 #include "user.h"
+#include "lcd.h"
+#include "format.h"
+#include "profile.h"
+#include "snapshot.h"
+#include "protect.h"
+
+/******************************************************************************/
+/* User Variables                                                             */
+/******************************************************************************/
+
+static unsigned char EdgeUpLast[AxisCount]; // Edge counters at the last ReadEncoder
+static unsigned char EdgeDownLast[AxisCount];
+static unsigned char EdgeIllegalLast[AxisCount];
+static unsigned char EdgeNoneLast;
+static unsigned char DisplayRuns;       // DisplayTask calls, stops counting after the blink
+static unsigned char FaultShown;        // ProtFault on the LCD, 0 for the start up message
 
 /******************************************************************************/
 /* User Functions                                                             */
 /******************************************************************************/
 
 /**********************************
-* InitApp: Initialize ports as I/O for LEDS, LCD, encoder. Light up LEDS to show
- * initialization on pic.
+* InitApp: Initialize ports as I/O for LEDS, LCD, encoder. The start up LED
+ * sequence is run by DisplayTask once the scheduler is going.
 ***********************************/
 void InitApp(void)
 {
@@ -26,6 +45,11 @@ void InitApp(void)
     TRISA = 0b11100001;		// Set I/O for PORTA (LEDS)
     TRISBbits.RB4 = 1;		// Set bit 4 as input on PORTB	(to read from encoder)
     TRISBbits.RB5 = 1;		// Set bit 5 as input on PORTB	(to read from encoder)
+#if AxisCount > 1
+    TRISBbits.RB6 = 1;          // RB6, RB7 as inputs for the axis 1 encoder
+    TRISBbits.RB7 = 1;          // ...
+    TRISCbits.RC1 = 0;          // Set C1 as output for PWM to motor 1 (CCP2)
+#endif
     TRISBbits.RB1 = 0;		// Set bit 1 as output on PORTB	(to power encoder)
     PORTBbits.RB1 = 1;          // Output power to encoder
     TRISCbits.RC2 = 0;          // Set C2 as output for PWM to motor
@@ -33,38 +57,15 @@ void InitApp(void)
     TRISE = 0b00000100;		// Set I/O for PORTE (LCD)
     ADCON1 = 0b10000111;	// Configure for using LCD
     
-    //------------
-    // Light up leds
-    PORTA  = 0b00010000;	// Turn all LEDs off to initialize
-    PORTAbits.RA3 = 1;		// Turn on D4 LED
-    WaitHalfSec();		// Wait 0.5 sec with D4 on
-    PORTAbits.RA3 = 0;		// Turn off D4 LED
-    PORTAbits.RA2 = 1;		// Turn on D5 LED
-    WaitHalfSec();		// Wait 0.5 sec with D5 on
-    PORTAbits.RA2 = 0;		// Turn off D5 LED
-    PORTAbits.RA1 = 1;          // Turn on D6 LED
-    WaitHalfSec();		// Wait 0.5 sec with D6 on
-    PORTAbits.RA1 = 0;          // Turn off D6 LED
+    PORTA  = 0b00010000;	// Turn all LEDs off to initialize (DisplayTask blinks them)
 
 }
 
-/**********************************
-* WaitHalfSec: Delay for 0.5 seconds
-***********************************/
-void WaitHalfSec(void)
-{
-    int Halfcount = 50;			// Load count for 0.5 sec using 10 ms delay
-    while (Halfcount != 0)
-    {
-            Delay1KTCYx(25);		// Use delay function for 10 ms count
-            Halfcount = Halfcount-1;	// Decrement 0.5 sec count
-    }
-}
-
 /*******************************
  * DisplayLCD(char * tempPtr, int init):
  * This subroutine is called with a string to be displayed on the LCD
- * It sends the bytes of the string to the LCD.  The first
+ * It queues the bytes of the string for the LCD and returns immediately; the
+ * Timer2 tick (LCDService) sends them in the background.  The first
  * byte sets the cursor position.  The remaining bytes are displayed, beginning
  * at that position.
  * This subroutine expects a normal one-byte cursor-positioning code, 0xhh, or
@@ -74,47 +75,13 @@ void WaitHalfSec(void)
  *******************************/
 void DisplayLCD(char * tempPtr, int init)
 {
-        char currentChar;
-        
-        
-
         if (init == 1)
         {
-            Delay1KTCYx(250);               // Wait 0.1 s to bypass LCD startup
-            PORTEbits.RE0 = 0;              // Drive RS pin low for cursor-positioning code
-            while (*tempPtr != 0)           // if the byte is not zero
-            {
-              currentChar = *tempPtr;
-              PORTEbits.RE1 = 1;            // Drive E pin high
-              PORTD = currentChar;          // Send upper nibble
-              PORTEbits.RE1 = 0;            // Drive E pin low so LCD will accept nibble
-              Delay100TCYx(250);			// Wait 10 ms
-              currentChar <<= 4;            // Shift lower nibble to upper nibble
-              PORTEbits.RE1 = 1;            // Drive E pin high again
-              PORTD = currentChar;          // Write lower nibble
-              PORTEbits.RE1 = 0;            // Drive E pin low so LCD will process byte
-              Delay100TCYx(250);            // Wait 10 ms
-              tempPtr++;                    // Increment pointerto next character
-            }
+            LCDInit(tempPtr);               // Queue init string after startup delay
         }
         else
         {
-            PORTEbits.RE0 = 0;              // Drive RS pin low for cursor-positioning code
-            while (*tempPtr)                // if the byte is not zero
-            {
-              currentChar = *tempPtr;
-              PORTEbits.RE1 = 1;            // Drive E pin high
-              PORTD = currentChar;          // Send upper nibble
-              PORTEbits.RE1 = 0;            // Drive E pin low so LCD will accept nibble
-              currentChar <<= 4;            // Shift lower nibble to upper nibble
-              PORTEbits.RE1 = 1;            // Drive E pin high again
-              PORTD = currentChar;          // Write lower nibble
-              PORTEbits.RE1 = 0;            // Drive E pin low so LCD will process byte
-              Delay10TCYx(10);              // Wait 40 usec
-              PORTEbits.RE0 = 1;            // Drive RS pin high for displayable characters
-              tempPtr++;                    // Increment pointerto next character
-            }
-
+            LCDWrite(tempPtr);              // Update frame buffer, changed cells only
         }
 }
 
@@ -122,9 +89,17 @@ void DisplayLCD(char * tempPtr, int init)
  * InitInterrupts(void)
  *
  * This subroutine initializes interrupts. One interrupt is
- * from Port B (encoder at B4, B5) and will be implement as a low priority to
- * determine wheel speed. Timer0 overflow is also used as an interrupt to sample
- * rev/s of the encoder as a low priority interrupt.
+ * from Port B (encoder at B4, B5, axis 1 at B6, B7) and is the only high
+ * priority source; it just latches the edge (see high_isr and ReadEncoder). The low priority
+ * sample tick that turns counts into rev/s is the CCP2 special event, which
+ * resets Timer1 (Timer3 in SpeedTimer1) every SpeedTickMs. With SpeedMode ==
+ * SpeedTimer1 the PortB interrupt is left off and Timer1 counts channel A
+ * pulses in hardware instead, and with SpeedMT CCP2 timestamps channel A edges
+ * on Timer3 and the sample tick is the Timer0 overflow. With two axes CCP2 is
+ * the PWM of axis 1 and the sample tick is the Timer0 overflow too. With
+ * EncoderSampled the PortB interrupt is off and the Timer0 overflow samples
+ * the encoder pins at high priority instead. Timer2 (PWM period, 1 ms) is the
+ * low priority tick that runs the speed loops and paces the LCD driver.
  *******************************/
 void InitInterrupts(void)
 {
@@ -137,9 +112,62 @@ void InitInterrupts(void)
     //-------------------
     // PortB interrupts
     INTCON2bits.NOT_RBPU = 0;               // All portB pullups enabled
-    INTCON2bits.RBIP = 0;                   // PortB interrupt as low priority
+    INTCON2bits.RBIP = 1;                   // PortB interrupt as high priority (edge latch only)
     INTCONbits.RBIF = 0;                    // Clear portB interrupt flag
+#if SpeedMode == SpeedTimer1
+    INTCONbits.RBIE = 0;                    // Edges are counted by Timer1 instead
+
+    //-------------------
+    // Timer1 setup: count channel A rising edges on T13CKI (RC0)
+    TRISCbits.RC0 = 1;                      // T13CKI as input
+    T1CONbits.RD16 = 1;                     // 16 bit reads
+    T1CONbits.T1CKPS1 = 0;                  // 1:1 prescaler
+    T1CONbits.T1CKPS0 = 0;                  // ...
+    T1CONbits.T1OSCEN = 0;                  // Timer1 oscillator off
+    T1CONbits.NOT_T1SYNC = 0;               // Synchronize to the instruction clock
+    T1CONbits.TMR1CS = 1;                   // Clock from T13CKI
+    WriteTimer1(0);                         // Start counting from 0
+    T1CONbits.TMR1ON = 1;                   // Turn on Timer1
+#elif SpeedMode == SpeedMT
+    INTCONbits.RBIE = 0;                    // Edges are timed by CCP2 instead
+
+    //-------------------
+    // Timer3 setup: free running timebase for CCP2 capture
+    T3CONbits.RD16 = 1;                     // 16 bit reads
+    T3CONbits.T3CCP2 = 0;                   // Timer3 for CCP2, Timer1 for CCP1
+    T3CONbits.T3CCP1 = 1;                   // ...
+    T3CONbits.T3CKPS1 = 1;                  // 1:8 prescaler (3.2 us)
+    T3CONbits.T3CKPS0 = 1;                  // ...
+    T3CONbits.TMR3CS = 0;                   // Internal clock
+    T3CONbits.TMR3ON = 1;                   // Turn on Timer3
+
+    //-------------------
+    // CCP2 capture of channel A rising edges on RC1
+    TRISCbits.RC1 = 1;                      // CCP2 as input
+    CCP2CON = 0b00000101;                   // Capture every rising edge
+    PIR2bits.CCP2IF = 0;                    // Clear CCP2 interrupt flag
+    IPR2bits.CCP2IP = 0;                    // CCP2 capture as low priority
+    PIE2bits.CCP2IE = 1;                    // Enable CCP2 interrupt
+#elif EncoderSampled
+    INTCONbits.RBIE = 0;                    // Pins are sampled on Timer0 instead
+
+    //-------------------
+    // Timer0 setup: 8 bit, free running, overflow every EncSampleCycles
+    T0CONbits.T08BIT = 1;                   // Timer0 as 8 bit timer
+    T0CONbits.T0CS = 0;                     // Timer0 clock source as internal
+#if EncSampleLog2 == 0
+    T0CONbits.PSA = 1;                      // No prescaler
+#else
+    T0CONbits.PSA = 0;                      // Prescaler 1:2^EncSampleLog2
+    T0CON = (T0CON & 0xF8) | (EncSampleLog2 - 1);
+#endif
+    INTCONbits.TMR0IF = 0;                  // Clear Timer0 interrupt flag
+    INTCON2bits.TMR0IP = 1;                 // Timer0 overflow as high priority (pin sampling)
+    INTCONbits.TMR0IE = 1;                  // Enable Timer0 interrupt
+    T0CONbits.TMR0ON = 1;                   // Turn on Timer0
+#else
     INTCONbits.RBIE = 1;                    // Enable portB interrupts
+#endif
 
     //------------------
     // PWM setup
@@ -147,9 +175,16 @@ void InitInterrupts(void)
     CCP1CONbits.CCP1M2 = 1;                 // ...
     CCP1CONbits.CCP1M1 = 0;
     CCP1CONbits.CCP1M0 = 0;
+#if AxisCount > 1
+    CCP2CONbits.CCP2M3 = 1;                 // Enable CCP2 in PWM mode (axis 1)
+    CCP2CONbits.CCP2M2 = 1;                 // ...
+    CCP2CONbits.CCP2M1 = 0;
+    CCP2CONbits.CCP2M0 = 0;
+#endif
 
+#if SpeedTickTimer0
     //-------------------
-    // Timer0 interrupt setup
+    // Timer0 interrupt setup (sample tick; CCP2 is busy capturing or as PWM)
     INTCONbits.TMR0IF = 0;                  // Clear Timer0 interrupt flag
     INTCON2bits.TMR0IP = 0;                 // Timer0 overflow as low priority
     INTCONbits.TMR0IE = 1;                  // Enable Timer0 interrupt
@@ -158,8 +193,53 @@ void InitInterrupts(void)
     // Timer0 setup
     T0CONbits.T08BIT = 0;                   // Timer0 as 16 bit timer
     T0CONbits.T0CS = 0;                     // Timer0 clock source as internal
+#if SpeedTickPrescale == 1
     T0CONbits.PSA = 1;                      // No prescaler
+#else
+    T0CONbits.PSA = 0;                      // Prescaler 1:2^T0PS+1 as SpeedTickPrescale
+    T0CON = (T0CON & 0xF8) | (SpeedTickCKPS - 1);
+#endif
     T0CONbits.TMR0ON = 1;                   // Turn on Timer0
+#if SpeedMode != SpeedMT
+    //-------------------
+    // Timer3 setup: free running at 1:1, the clock of SpeedT2Periods
+    T3CONbits.RD16 = 1;                     // 16 bit reads
+    T3CONbits.T3CKPS1 = 0;                  // 1:1 prescaler
+    T3CONbits.T3CKPS0 = 0;                  // ...
+    T3CONbits.TMR3CS = 0;                   // Internal clock
+    T3CONbits.TMR3ON = 1;                   // Turn on Timer3
+#endif
+#else
+    //-------------------
+    // Sample tick timebase: CCP2 compare with special event trigger resets
+    // the timer in hardware every SpeedTickMs (also starts the A/D if it is on)
+#if SpeedMode == SpeedEdgeISR
+    T1CONbits.RD16 = 1;                     // 16 bit reads
+    T1CONbits.T1CKPS1 = (SpeedTickCKPS >> 1) & 1; // Prescaler SpeedTickPrescale
+    T1CONbits.T1CKPS0 = SpeedTickCKPS & 1;  // ...
+    T1CONbits.T1OSCEN = 0;                  // Timer1 oscillator off
+    T1CONbits.TMR1CS = 0;                   // Internal clock
+    T3CONbits.T3CCP2 = 0;                   // Timer1 for CCP1 and CCP2
+    T3CONbits.T3CCP1 = 0;                   // ...
+    WriteTimer1(0);                         // Start the first period
+    T1CONbits.TMR1ON = 1;                   // Turn on Timer1
+#else
+    T3CONbits.RD16 = 1;                     // 16 bit reads
+    T3CONbits.T3CCP2 = 0;                   // Timer3 for CCP2, Timer1 (pulse count) for CCP1
+    T3CONbits.T3CCP1 = 1;                   // ...
+    T3CONbits.T3CKPS1 = (SpeedTickCKPS >> 1) & 1; // Prescaler SpeedTickPrescale
+    T3CONbits.T3CKPS0 = SpeedTickCKPS & 1;  // ...
+    T3CONbits.TMR3CS = 0;                   // Internal clock
+    WriteTimer3(0);                         // Start the first period
+    T3CONbits.TMR3ON = 1;                   // Turn on Timer3
+#endif
+    CCPR2H = (unsigned char)(SpeedTickCompare >> 8); // Period - 1 timer counts
+    CCPR2L = (unsigned char)SpeedTickCompare;
+    CCP2CON = 0b00001011;                   // Compare, special event trigger
+    PIR2bits.CCP2IF = 0;                    // Clear CCP2 interrupt flag
+    IPR2bits.CCP2IP = 0;                    // Sample tick as low priority
+    PIE2bits.CCP2IE = 1;                    // Enable CCP2 interrupt
+#endif
 
     //------------------
     // Timer2 setup
@@ -167,6 +247,11 @@ void InitInterrupts(void)
     T2CONbits.T2CKPS0 = 1;                  // ...
     T2CONbits.TMR2ON = 1;                   // Turn on Timer2
 
+    //-------------------
+    // Timer2 interrupt setup (1 ms tick, postscaler 1:1)
+    PIR1bits.TMR2IF = 0;                    // Clear Timer2 interrupt flag
+    IPR1bits.TMR2IP = 0;                    // Timer2 match as low priority
+    PIE1bits.TMR2IE = 1;                    // Enable Timer2 interrupt
     
 
     
@@ -176,106 +261,162 @@ void InitInterrupts(void)
 /*******************************
  * ReadEncoder(void):
  *
- * This subroutine is called by the low priority ISR to sample the encoder. This
- * subroutine checks the current quadrature output of the encoder on PortB RB5
- * (channelA) and PortB RB4 (channelB) and compares with the previous states,
- * CHA and CHB. Based on the quadrature table (stored as a vector in QEM), the
- * new and old quadrature outputs are compared to determine CW,CCW, or encoder
- * bouncing. When NEW_ROT = 1: CW turn, NEW_ROT = -1: CCW turn, NEW_ROT = 0, no
- * turn, NEW_ROT = 2 encoder is bouncing and we don't trust the current output.
- * When a bounce occurs the routine uses the previous rotation as the current
- * rotation and does not adjust CHA,CHB. A bounce can also occur where it apears
- * as though the encoder is rotating in the opposite direction. To deal with this,
- * global variables CCWTurn and CWTurn are used to count how many CCW or CW turns
- * occur over a defined number of counts (EncoderPoll). When EncoderPoll is reached
- * the variable (CCWTurn or CWTurn) with the most counts dictates the rotation of
- * the encoder. Finally if no bouncing occurs, the CHA, CHB, OLD_ROT variables are
- * updated for the next reading.
+ * This subroutine is called by the low priority ISR on every Timer2 and
+ * sample tick when SpeedMode == SpeedEdgeISR. The RB-change edges themselves
+ * are decoded in high_isr at full 4x quadrature resolution: PORTB is read once
+ * and the new channel bits of every axis (A1 B1 A0 B0 on RB7:RB4) are shifted
+ * in under the previous ones, so EncoderState holds old*16+new, and for each
+ * axis whose pair changed the transition bumps one of its free running byte
+ * counters EdgeUp, EdgeDown or EdgeIllegal (encoder.h);
+ * an interrupt where no pin changed bumps EdgeNone. Here the counters are
+ * compared with their values at the last call; each byte read is atomic, so
+ * no interrupt masking is needed as long as fewer than 256 edges of one kind
+ * arrive between calls (256 per ms is far above what high_isr can take).
+ * The net count is added to EncoderPos of the axis. Illegal transitions are
+ * tallied in EncoderErrors and the position is left alone. Illegal and empty
+ * interrupts both mean edges were missed and are tallied in EncoderMissed;
+ * an empty one cannot be put down to either axis, so it counts for both.
  *******************************/
 void ReadEncoder(void)
 {
-    //int QEM[] = {0,-1,1,2,1,0,2,-1,-1,2,0,1,2,1,-1,0};
-    int Anew = PORTBbits.RB5;           // Read new channel A
-    int Bnew = PORTBbits.RB4;           // Read new channel B
+    unsigned char None = EdgeNone;      // Single byte reads, no masking
+    unsigned char Empty = (unsigned char)(None - EdgeNoneLast);
+    unsigned char Up;
+    unsigned char Down;
+    unsigned char Illegal;
+    unsigned char a;
 
-    int Old = CHA*2 + CHB;              // Convert previous CHA,CHB into integer value
-    int New = Anew*2 + Bnew;            // Convert new A,B into integer value
-    int NEW_ROT = QEM[Old*4+New];       // Determine rotation of encoder
+    EdgeNoneLast = None;
+    for (a = 0; a < AxisCount; a++)
+    {
+        Up = EdgeUp[a];
+        Down = EdgeDown[a];
+        Illegal = EdgeIllegal[a];
+        EncoderPos[a] += (int)(unsigned char)(Up - EdgeUpLast[a]) - (int)(unsigned char)(Down - EdgeDownLast[a]);
+        EncoderErrors[a] += (unsigned char)(Illegal - EdgeIllegalLast[a]);
+        EncoderMissed[a] += (unsigned char)(Illegal - EdgeIllegalLast[a]) + Empty;
+        EdgeUpLast[a] = Up;
+        EdgeDownLast[a] = Down;
+        EdgeIllegalLast[a] = Illegal;
+    }
+}
 
-    if (NEW_ROT == 2)                   // Shits fucked so don't trust it
+
+/*******************************
+ * ReadPulseCount(void):
+ *
+ * This subroutine is called by the low priority ISR on every sample tick when
+ * SpeedMode == SpeedTimer1, and on every Timer2 tick too for SpeedObserver.
+ * Timer1 counts channel A rising edges of axis 0 on T13CKI in hardware, so
+ * there is no interrupt per edge. The 16 bit count is read and the difference
+ * since the last tick is added to EncoderPos, scaled by 4 to keep quadrature
+ * units. Timer1 is never cleared, so no edges are lost
+ * between the read and a clear; it only has to not wrap within one 25 ms tick
+ * (65535 edges, over 5000 rev/s). Channel B is not used, so the direction is
+ * always taken as CW.
+ *******************************/
+void ReadPulseCount(void)
+{
+    unsigned int Now = ReadTimer1();    // TMR1L then TMR1H (RD16)
+
+    EncoderPos[0] += 4L*(unsigned int)(Now - PulseLast);
+    PulseLast = Now;
+}
+
+
+/*******************************
+ * WriteLCD(int LCDstart, int len, long var, char Msg[])
+ *
+ * This subroutine takes a fixed point variable var (in units of 1/RPSScale),
+ * and outputs it to the LCD. Here LCDstart tells the LCD where to place the
+ * desired message (hex), and len dictates how long the message is that will
+ * be displayed. The value is formatted right aligned in len characters with
+ * as many of its RPSDigits decimals as fit (FormatFixed, no sprintf or float).
+ * Msg must hold len+2 bytes. If the integer part is larger than len then the
+ * field is filled with the warning symbol '!'.
+ *******************************/
+void WriteLCD( int LCDstart, int len, long var, char Msg[] )
+{
+    Msg[0] = LCDstart;      // Set LCD start at beginning of array
+    FormatFixed(Msg+1, var, RPSDigits, len, RPSDigits, '!');
+    DisplayLCD(Msg,0);      // Display the message on the LCD
+}
+
+/*******************************
+ * ShowFault(unsigned char fault)
+ *
+ * Writes a protection fault (ProtFault) to the first LCD line as
+ * "FAULT a name", a being the axis, or with 0 puts the start up message back.
+ *******************************/
+static void ShowFault(unsigned char fault)
+{
+    static char Msg[18];                // Cursor byte, 16 characters, terminator
+    static const char Names[4][8] = {"?      ", "stall  ", "overspd", "encoder"};
+    unsigned char code = fault & 0x0F;
+
+    memset(Msg, ' ', sizeof Msg - 1);
+    Msg[0] = 0x80;
+    Msg[17] = '\0';
+    if (fault == 0)
     {
-        NEW_ROT = OLD_ROT;              // Use previous rotation either +1:CW, -1:CCW, 0
+        memcpy(Msg+5, "CUNT", 4);       // As main writes it at 0x84
     }
     else
     {
-        CHA = Anew;                     // Update state of channel A
-        CHB = Bnew;                     // Update state of channel B
+        memcpy(Msg+1, "FAULT", 5);
+        Msg[7] = '0' + (fault >> 4);
+        memcpy(Msg+9, Names[(code < 4) ? code : 0], 7);
     }
+    DisplayLCD(Msg,0);
+}
+
+/*******************************
+ * DisplayTask(void)
+ *
+ * Main loop task, every DisplayPeriod ticks (500 ms). The first runs step the
+ * start up sequence D4, D5, D6 that InitApp used to block on; after that D4
+ * and D5 show the direction and D6 a latched protection fault. Writes RPS to
+ * the second LCD line and, in ISRProfile builds, one ISR statistics page to
+ * the first. A protection fault takes the first line while it is latched.
+ *******************************/
+void DisplayTask(void)
+{
+    static char Msg[10];                // RPS message (size 10 in case dealing with large numbers)
+    SpeedSnap Snap;
+#if ISRProfile
+    static char ProfMsg[18];            // Cursor byte, 16 characters of ISR statistics, terminator
+    static unsigned char ProfPage;
+#endif
+
+    SnapRead(&Snap);                    // RPS is written by the ISR
 
-    if (NEW_ROT == 1)                   // Update tally of CW turns if NEW_ROT = 1
+    if (DisplayRuns < 3)
     {
-        CWTurn += 1;
+        PORTAbits.RA3 = (DisplayRuns == 0); // D4, then D5, then D6
+        PORTAbits.RA2 = (DisplayRuns == 1);
+        PORTAbits.RA1 = (DisplayRuns == 2);
+        DisplayRuns++;
     }
-    else if (NEW_ROT == -1)             // Update tally of CCW turns if NEW_ROT = -1
+    else
     {
-        CCWTurn += 1;
+        PORTAbits.RA1 = (ProtFault != 0); // D6 on while a fault is latched
+        HalLEDCW(Snap.RPS[0] > 0);      // D4 on for CW rotation (axis 0)
+        HalLEDCCW(Snap.RPS[0] < 0);     // D5 on for CCW rotation
     }
 
-    if (CWTurn + CCWTurn == EncoderPoll)// Once total count is reached determine rotation direction
+    WriteLCD(0xC0,5,Snap.RPS[0],Msg);   // Display RPS of axis 0 on LCD
+    if (ProtFault != FaultShown)        // Single byte read, set by the ISRs
     {
-        if (CWTurn > CCWTurn)           // If majority is CWturning
-        {
-            PORTAbits.RA3 = 1;
-            PORTAbits.RA2 = 0;
-            PORTAbits.RA1 = 0;
-            PartialRot -= ((double)EncoderPoll)/CountPerRev; // Negative partial rotation
-        }
-        else if (CWTurn < CCWTurn)      // If majority is CCW turning
-        {
-            PORTAbits.RA3 = 0;
-            PORTAbits.RA2 = 1;
-            PORTAbits.RA1 = 0;
-            PartialRot += ((double)EncoderPoll)/CountPerRev; // Positive partial rotation
-        }
-        else
-        {
-            PORTAbits.RA3 = 0;
-            PORTAbits.RA2 = 0;
-            PORTAbits.RA1 = 0;
-        }
-
-        CWTurn = 0;                     // Reset CW counter
-        CCWTurn = 0;                    // Reset CCW counter
+        FaultShown = ProtFault;
+        ShowFault(FaultShown);
     }
-    
-
-    OLD_ROT = NEW_ROT;
-    
-}
-
-
-/*******************************
- * WriteLCD(int LCDstart, int dispLength, double var)
- *
- * This subroutine takes a numeric variable var, and outputs it to the LCD. Here
- * LCDstart tells the LCD where to place the desired message (hex), and len
- * dictates how long the message is that will be displayed. In order to display
- * the variable, this subroutine uses sprintf to convert the variable into a
- * string with the specified width and #sig figs. Warning: be careful if var
- * has several decimal places of precision. May overwrite other data in memory
- * passed the size of Msg. The if statement prevents displaying anything larger
- * than len+1 to the LCD
- *******************************/
-void WriteLCD( int LCDstart, int len, double var, char Msg[] )
-{
-    char *msgptr = Msg;     // Point to message string
-    int width = sprintf(msgptr+1,"%*.*g",len,len-1,var);    // Define minimum # characters as
-                            // len, #significant digits len-1
-    Msg[0] = LCDstart;      // Set LCD start at beginning of array
-    if (width > len)        // If string is larger than desired length, len
-    {                       // then output warning symbol '!' to LCD 
-        Msg[len] = '!';     // and terminate string at len+1
-        Msg[len+1] = '\0';
+#if ISRProfile
+    if (FaultShown == 0)
+    {
+        ProfMsg[0] = 0x80;              // Top line shows one ISR statistics page
+        ProfReport(ProfMsg+1, ProfPage);
+        DisplayLCD(ProfMsg,0);
+        ProfPage = (ProfPage < ProfBranches) ? ProfPage+1 : 0;
     }
-    DisplayLCD(Msg,0);      // Display the message on the LCD
-}
\ No newline at end of file
+#endif
+}
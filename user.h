@@ -8,21 +8,25 @@
 #ifndef MYUSER_H
 #define	MYUSER_H
 
+#define DisplayPeriod 500       // DisplayTask period, scheduler ticks (ms)
+
 /*----------------------------------------------------------------------------*/
 /*Function Prototypes*/
 /*----------------------------------------------------------------------------*/
 
 void InitApp(void);
 
-void WaitHalfSec(void);
-
 void DisplayLCD(char * tempPtr, int init);
 
 void InitInterrupts(void);
 
 void ReadEncoder(void);
 
-void WriteLCD(int LCDstart, int len, double var, char Msg[]);
+void ReadPulseCount(void);
+
+void WriteLCD(int LCDstart, int len, long var, char Msg[]);
+
+void DisplayTask(void);
 
 
 